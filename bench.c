@@ -0,0 +1,1475 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+/*
+ * Benchmark driver for ringbuffer-c
+ *
+ * Usage:
+ *   bench [options] replay <trace> [checked|nocheck|compact] [repetitions]
+ *       Replays a trace recorded with ringbuffer_trace_start() at full speed
+ *   bench [options] scale [max-threads] [messages-per-producer] [cpu-list]
+ *       Sweeps 1..max-threads producers and consumers (powers of two) over
+ *       each concurrency mode (mutex-wrapped ringbuffer_t, work-stealing
+ *       deques, a two-stage pipeline consuming in place and a credit-
+ *       controlled ringbuffer, the latter two also mutex-wrapped),
+ *       reporting throughput and latency percentiles. Threads are
+ *       pinned to the CPUs in <cpu-list> in order of creation (producers
+ *       first), e.g. "0,32,1,33" to alternate between two sockets.
+ *   bench [options] find [ring-size] [repetitions]
+ *       Compares ringbuffer_find, ringbuffer_rfind and ringbuffer_find_any
+ *       against memmem, memrchr and a table lookup on a linearized copy, and
+ *       ringbuffer_find_parallel against ringbuffer_find, over several
+ *       corpora, pattern lengths 1..256 and matches placed before, across
+ *       and after the ringbuffer's wrap point
+ *   bench [options] parallel [ring-size] [max-threads]
+ *       Runs ringbuffer_find_parallel and ringbuffer_crc32_parallel over a
+ *       full ringbuffer with 1..max-threads chunks (powers of two)
+ *
+ * Options:
+ *   -p          Report hardware performance counters per operation (Linux)
+ *   -r <config> Additionally count raw PMU event <config> (hex), e.g. a
+ *               model-specific HITM event to count cache-line transfers
+ */
+
+#define _GNU_SOURCE
+
+#include "ringbuffer.h"
+#include "ringbuffer_compact.h"
+#include "ringbuffer_credit.h"
+#include "ringbuffer_deque.h"
+#include "ringbuffer_parallel.h"
+#include "ringbuffer_pipeline.h"
+#include "ringbuffer_trace.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+/*
+ * Ringbuffer modes to run benchmarks against
+ */
+#define BENCH_MODE_CHECKED  0
+#define BENCH_MODE_NOCHECK  1
+#define BENCH_MODE_COMPACT  2
+
+static const char* bench_mode_names[] = { "checked", "nocheck", "compact" };
+
+#define BENCH_NUM_MODES 3
+
+
+/*
+ * Hardware performance counters reported per operation
+ */
+#define BENCH_NUM_COUNTERS 6
+
+static const char* bench_counter_names[] = {
+        "cycles", "instr", "L1D-miss", "LLC-miss", "br-miss", "raw" };
+
+
+/*
+ * A set of hardware performance counters (-1 = not available)
+ */
+typedef struct {
+
+    int fd[BENCH_NUM_COUNTERS];
+
+    uint64_t value[BENCH_NUM_COUNTERS];
+
+} bench_perf_t;
+
+
+/* Whether to report performance counters (-p) */
+static int bench_perf_enabled = 0;
+
+/* Raw PMU event to count in addition (-r, 0 = none) */
+static uint64_t bench_perf_raw = 0;
+
+
+/*
+ * A ringbuffer in any of the benchmark modes
+ */
+typedef struct {
+
+    int mode;
+
+    ringbuffer_t rb;
+
+    ringbuffer_compact_t* rbc;
+
+    uint8_t* mem;
+
+} bench_ring_t;
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static uint64_t bench_now(void) {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void bench_perf_open(bench_perf_t* perf) {
+
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+        perf->fd[i] = -1;
+        perf->value[i] = 0;
+    }
+
+#ifdef __linux__
+    if (!bench_perf_enabled) {
+        return;
+    }
+
+    struct { uint32_t type; uint64_t config; } events[BENCH_NUM_COUNTERS] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_RAW, bench_perf_raw }
+    };
+
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+
+        if (events[i].type == PERF_TYPE_RAW && bench_perf_raw == 0) {
+            continue;
+        }
+
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[i].type;
+        attr.config = events[i].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        /* also count threads spawned by concurrent benchmarks */
+        attr.inherit = 1;
+
+        perf->fd[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+#endif
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void bench_perf_start(bench_perf_t* perf) {
+
+#ifdef __linux__
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+        if (perf->fd[i] >= 0) {
+            ioctl(perf->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    (void)perf;
+#endif
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void bench_perf_stop(bench_perf_t* perf) {
+
+#ifdef __linux__
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+        if (perf->fd[i] >= 0) {
+            ioctl(perf->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+#else
+    (void)perf;
+#endif
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void bench_perf_close(bench_perf_t* perf, double ops) {
+
+    if (!bench_perf_enabled) {
+        return;
+    }
+
+    printf("        ");
+
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+
+#ifdef __linux__
+        if (perf->fd[i] >= 0) {
+            /* Counters accumulate over all enabled periods */
+            if (read(perf->fd[i], &perf->value[i], sizeof(uint64_t))
+                    == sizeof(uint64_t)) {
+                printf(" %s/op %.2f", bench_counter_names[i],
+                        perf->value[i] / ops);
+            } else {
+                printf(" %s/op n/a", bench_counter_names[i]);
+            }
+            close(perf->fd[i]);
+            perf->fd[i] = -1;
+            continue;
+        }
+#endif
+        if (i < BENCH_NUM_COUNTERS - 1 || bench_perf_raw != 0) {
+            printf(" %s/op n/a", bench_counter_names[i]);
+        }
+    }
+
+    printf("\n");
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static int bench_parse_mode(const char* name) {
+
+    for (int i = 0; i < BENCH_NUM_MODES; i++) {
+        if (strcmp(name, bench_mode_names[i]) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static int bench_ring_init(bench_ring_t* br, int mode, size_t size) {
+
+    br->mode = mode;
+    br->mem = malloc(RINGBUFFER_COMPACT_SIZEOF(size));
+    if (br->mem == 0) {
+        return -1;
+    }
+
+    int ret;
+    if (mode == BENCH_MODE_COMPACT) {
+        br->rbc = ringbuffer_compact_init(
+                br->mem, RINGBUFFER_COMPACT_SIZEOF(size));
+        ret = (br->rbc != 0) ? 0 : -1;
+    } else {
+        ret = (ringbuffer_init(&br->rb, br->mem, size) < 0) ? -1 : 0;
+    }
+
+    if (ret < 0) {
+        /* >>> Size not supported by the mode >>> */
+        free(br->mem);
+        br->mem = 0;
+    }
+
+    return ret;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void bench_ring_clear(bench_ring_t* br) {
+
+    if (br->mode == BENCH_MODE_COMPACT) {
+        ringbuffer_compact_clear(br->rbc);
+    } else {
+        ringbuffer_clear(&br->rb);
+    }
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void bench_ring_free(bench_ring_t* br) {
+
+    free(br->mem);
+    br->mem = 0;
+}
+
+
+/*
+ * Marks operations not supported in a ringbuffer mode
+ */
+#define BENCH_UNSUPPORTED (-1000)
+
+
+/*
+ * Applies a recorded operation to a ringbuffer. Returns the number of bytes
+ * moved (negative if the operation failed), or BENCH_UNSUPPORTED if the
+ * operation is not supported in the ringbuffer's mode.
+ * ___________________________________________________________________________
+ */
+static int bench_apply(bench_ring_t* br, const ringbuffer_trace_record_t* rec,
+        const uint8_t* src, uint8_t* dst) {
+
+    ringbuffer_t* rb = &br->rb;
+    size_t len = rec->len;
+    size_t aux = rec->aux;
+    int ret = 0;
+
+    if (br->mode == BENCH_MODE_CHECKED) {
+
+        switch (rec->op) {
+        case RINGBUFFER_OP_WRITE:
+            return ringbuffer_write(rb, src, len);
+        case RINGBUFFER_OP_WRITE_ALL:
+            return ringbuffer_write_all(rb, src, len);
+        case RINGBUFFER_OP_READ:
+            return ringbuffer_read(rb, dst, len);
+        case RINGBUFFER_OP_PEEK:
+            return ringbuffer_peek_offset(rb, aux, dst, len);
+        case RINGBUFFER_OP_DISCARD:
+            return ringbuffer_discard(rb, len);
+        case RINGBUFFER_OP_FIND:
+            ringbuffer_find(rb, aux, (uint8_t*)src, len);
+            return 0;
+        case RINGBUFFER_OP_WRITE_BLOCK:
+            return ringbuffer_write_block(rb, src, len);
+        case RINGBUFFER_OP_READ_BLOCK:
+            return ringbuffer_read_block(rb, dst, len);
+        case RINGBUFFER_OP_WRITE_FRAME:
+            return ringbuffer_write_frame(rb,
+                    (uint8_t*)src, aux, (uint8_t*)src + aux, len);
+        case RINGBUFFER_OP_READ_FRAME:
+            return ringbuffer_read_frame(rb, dst, aux, dst + aux, len);
+        case RINGBUFFER_OP_DISCARD_BLOCK:
+            return ringbuffer_discard_block(rb);
+        case RINGBUFFER_OP_CLEAR:
+            ringbuffer_clear(rb);
+            return 0;
+        case RINGBUFFER_OP_PEEK_BLOCK:
+            return ringbuffer_peek_block(rb, dst, len);
+        }
+
+    } else if (br->mode == BENCH_MODE_NOCHECK) {
+
+        /* The caller has to establish the preconditions */
+        size_t space = rb->size - rb->len;
+        int bl;
+
+        switch (rec->op) {
+        case RINGBUFFER_OP_WRITE:
+        case RINGBUFFER_OP_WRITE_ALL:
+            return ringbuffer_write_nocheck(rb, src, len < space ? len : space);
+        case RINGBUFFER_OP_READ:
+            return ringbuffer_read_nocheck(rb,
+                    dst, len < rb->len ? len : rb->len);
+        case RINGBUFFER_OP_PEEK:
+            if (aux + len > rb->len) {
+                len = (aux < rb->len) ? rb->len - aux : 0;
+                aux = (aux < rb->len) ? aux : 0;
+            }
+            return ringbuffer_peek_offset_nocheck(rb, aux, dst, len);
+        case RINGBUFFER_OP_DISCARD:
+            return ringbuffer_discard_nocheck(rb, len < rb->len ? len : rb->len);
+        case RINGBUFFER_OP_FIND:
+            ringbuffer_find(rb, aux, (uint8_t*)src, len);
+            return 0;
+        case RINGBUFFER_OP_WRITE_BLOCK:
+            if (len + sizeof(size_t) <= space) {
+                ret = ringbuffer_write_block_nocheck(rb, src, len);
+            }
+            return ret;
+        case RINGBUFFER_OP_READ_BLOCK:
+            bl = ringbuffer_peek_block_length(rb);
+            if (rb->len >= sizeof(size_t) && bl >= 0 && (size_t)bl <= len) {
+                ret = ringbuffer_read_block_nocheck(rb, dst, len);
+            }
+            return ret;
+        case RINGBUFFER_OP_WRITE_FRAME:
+            if (sizeof(size_t) + aux + len <= space) {
+                ret = ringbuffer_write_frame_nocheck(rb, src, aux, src + aux, len);
+            }
+            return ret;
+        case RINGBUFFER_OP_READ_FRAME:
+            bl = ringbuffer_peek_block_length(rb);
+            if (rb->len >= sizeof(size_t) && bl >= 0
+                    && (size_t)bl >= aux && (size_t)bl <= aux + len) {
+                ret = ringbuffer_read_frame_nocheck(rb, dst, aux, dst + aux, len);
+            }
+            return ret;
+        case RINGBUFFER_OP_DISCARD_BLOCK:
+            bl = ringbuffer_peek_block_length(rb);
+            if (bl > 0) {
+                ret = ringbuffer_discard_nocheck(rb, sizeof(size_t) + bl);
+            }
+            return ret;
+        case RINGBUFFER_OP_CLEAR:
+            ringbuffer_clear(rb);
+            return 0;
+        case RINGBUFFER_OP_PEEK_BLOCK:
+            bl = ringbuffer_peek_block_length(rb);
+            if (bl > 0) {
+                ret = ringbuffer_peek_offset_nocheck(rb, sizeof(size_t),
+                        dst, (size_t)bl < len ? (size_t)bl : len);
+            }
+            return ret;
+        }
+
+    } else if (br->mode == BENCH_MODE_COMPACT) {
+
+        switch (rec->op) {
+        case RINGBUFFER_OP_WRITE:
+            return ringbuffer_compact_write(br->rbc, src, len);
+        case RINGBUFFER_OP_WRITE_ALL:
+            return ringbuffer_compact_write_all(br->rbc, src, len);
+        case RINGBUFFER_OP_READ:
+            return ringbuffer_compact_read(br->rbc, dst, len);
+        case RINGBUFFER_OP_PEEK:
+            return ringbuffer_compact_peek_offset(br->rbc, aux, dst, len);
+        case RINGBUFFER_OP_DISCARD:
+            return ringbuffer_compact_discard(br->rbc, len);
+        case RINGBUFFER_OP_FIND:
+            ringbuffer_compact_find(br->rbc, aux, (uint8_t*)src, len);
+            return 0;
+        case RINGBUFFER_OP_CLEAR:
+            ringbuffer_compact_clear(br->rbc);
+            return 0;
+        }
+    }
+
+    /* >>> Operation not supported in this mode >>> */
+    return BENCH_UNSUPPORTED;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static int bench_replay(const char* path, int mode, int repetitions) {
+
+    ringbuffer_trace_t tr;
+    int size = ringbuffer_trace_open(&tr, path);
+    if (size <= 0) {
+        fprintf(stderr, "Cannot read trace '%s'\n", path);
+        return -1;
+    }
+
+    /* Load the whole trace such that file I/O doesn't disturb the replay */
+    size_t n = 0;
+    size_t cap = 1024;
+    size_t maxlen = 0;
+    uint64_t duration = 0;
+    ringbuffer_trace_record_t* recs = malloc(cap * sizeof(*recs));
+    int ret;
+
+    while (recs != 0 && (ret = ringbuffer_trace_next(&tr, &recs[n])) > 0) {
+        /* No operation on the ring moves more than its size, so lengths
+         * and offsets beyond it behave alike: clamp them to size + 1 such
+         * that the trace file cannot dictate the buffers allocated below */
+        if (recs[n].len > (size_t)size + 1) {
+            recs[n].len = (size_t)size + 1;
+        }
+        if (recs[n].aux > (size_t)size + 1) {
+            recs[n].aux = (size_t)size + 1;
+        }
+        if (recs[n].len + recs[n].aux > maxlen) {
+            maxlen = recs[n].len + recs[n].aux;
+        }
+        duration += recs[n].delta;
+        if (++n == cap) {
+            ringbuffer_trace_record_t* grown =
+                    realloc(recs, 2 * cap * sizeof(*recs));
+            if (grown == 0) {
+                fprintf(stderr, "Out of memory loading trace '%s'\n", path);
+                ringbuffer_trace_close(&tr);
+                free(recs);
+                return -1;
+            }
+            recs = grown;
+            cap *= 2;
+        }
+    }
+    ringbuffer_trace_close(&tr);
+
+    if (recs == 0 || ret < 0) {
+        fprintf(stderr, "Corrupt trace '%s'\n", path);
+        free(recs);
+        return -1;
+    }
+
+    /* Source and sink of replayed data */
+    uint8_t* src = malloc(maxlen + 1);
+    uint8_t* dst = malloc(maxlen + 1);
+    if (src == 0 || dst == 0) {
+        fprintf(stderr, "Out of memory\n");
+        free(src);
+        free(dst);
+        free(recs);
+        return -1;
+    }
+    for (size_t i = 0; i <= maxlen; i++) {
+        src[i] = (uint8_t)i;
+    }
+
+    printf("trace: %zu operations, ring size %d, recorded in %.3f ms\n",
+            n, size, duration / 1e6);
+
+    for (int m = 0; m < BENCH_NUM_MODES; m++) {
+
+        if (mode >= 0 && m != mode) {
+            continue;
+        }
+
+        uint64_t elapsed = 0;
+        uint64_t bytes = 0;
+        size_t skipped = 0;
+
+        bench_ring_t br;
+        if (bench_ring_init(&br, m, size) < 0) {
+            /* >>> Out of memory or size not supported by the mode >>> */
+            printf("%-8s n/a (cannot set up ring of %d bytes)\n",
+                    bench_mode_names[m], size);
+            continue;
+        }
+
+        bench_perf_t perf;
+        bench_perf_open(&perf);
+
+        for (int r = 0; r < repetitions; r++) {
+
+            /* Every repetition starts with an empty ring */
+            bench_ring_clear(&br);
+
+            bench_perf_start(&perf);
+            uint64_t t0 = bench_now();
+            for (size_t i = 0; i < n; i++) {
+                int moved = bench_apply(&br, &recs[i], src, dst);
+                if (moved > 0) {
+                    bytes += moved;
+                } else if (moved == BENCH_UNSUPPORTED && r == 0) {
+                    skipped++;
+                }
+            }
+            elapsed += bench_now() - t0;
+            bench_perf_stop(&perf);
+        }
+
+        bench_ring_free(&br);
+
+        printf("%-8s %10.2f ns/op %10.1f MB/s",
+                bench_mode_names[m], (double)elapsed / ((double)n * repetitions),
+                elapsed ? bytes * 1e3 / elapsed : 0.0);
+        if (skipped > 0) {
+            printf("  (%zu unsupported operations skipped)", skipped);
+        }
+        printf("\n");
+
+        bench_perf_close(&perf, (double)n * repetitions);
+    }
+
+    free(src);
+    free(dst);
+    free(recs);
+
+    return 0;
+}
+
+
+/*
+ * Concurrency modes of the contention-scaling benchmark
+ */
+#define BENCH_SCALE_MUTEX       0
+#define BENCH_SCALE_DEQUE       1
+#define BENCH_SCALE_PIPELINE    2
+#define BENCH_SCALE_CREDIT      3
+
+static const char* bench_scale_names[] = {
+        "mutex", "deque", "pipe", "credit" };
+
+#define BENCH_NUM_SCALE_MODES 4
+
+
+/* Size of the ringbuffer (or of each deque) in the scaling benchmark */
+#define BENCH_SCALE_RING_SIZE 65536
+
+/* Minimum number of bytes granted at once in credit mode */
+#define BENCH_SCALE_CREDIT_QUANTUM 4096
+
+/* Maximum number of latency samples kept per consumer */
+#define BENCH_SCALE_MAX_SAMPLES (1 << 20)
+
+
+/*
+ * A message passed from producers to consumers
+ */
+typedef struct {
+
+    /* time the message has been produced (ns) */
+    uint64_t timestamp;
+
+    /* producer-local sequence number */
+    uint64_t seq;
+
+} bench_msg_t;
+
+
+/*
+ * State shared by all threads of a scaling benchmark run
+ */
+typedef struct {
+
+    int mode;
+
+    int nprod;
+
+    int ncons;
+
+    /* messages per producer */
+    size_t ops;
+
+    /* mutex, pipeline and credit mode: the shared ringbuffer and its lock */
+    ringbuffer_t rb;
+    pthread_mutex_t lock;
+
+    /* pipeline mode: two stages on the shared ringbuffer */
+    ringbuffer_pipeline_t pl;
+    size_t cursors[2];
+
+    /* credit mode: flow control of the shared ringbuffer */
+    ringbuffer_credit_t credit;
+
+    /* deque mode: one deque per producer */
+    ringbuffer_deque_t* deques;
+
+    /* total number of messages consumed so far */
+    size_t consumed;
+
+    /* CPUs to pin threads to (in order of thread creation) */
+    const int* cpus;
+    int ncpus;
+
+} bench_scale_t;
+
+
+/*
+ * Per-thread state of a scaling benchmark run
+ */
+typedef struct {
+
+    bench_scale_t* sc;
+
+    int index;
+
+    pthread_t thread;
+
+    /* consumers: latency samples (ns) */
+    uint64_t* samples;
+    size_t nsamples;
+    size_t maxsamples;
+
+} bench_worker_t;
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void bench_pin(bench_scale_t* sc, int index) {
+
+#ifdef __linux__
+    if (sc->ncpus > 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(sc->cpus[index % sc->ncpus], &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#else
+    (void)sc;
+    (void)index;
+#endif
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void* bench_producer(void* arg) {
+
+    bench_worker_t* w = (bench_worker_t*)arg;
+    bench_scale_t* sc = w->sc;
+
+    bench_pin(sc, w->index);
+
+    bench_msg_t msg;
+
+    for (msg.seq = 0; msg.seq < sc->ops; msg.seq++) {
+
+        int ret;
+        do {
+            msg.timestamp = bench_now();
+            if (sc->mode == BENCH_SCALE_CREDIT) {
+                pthread_mutex_lock(&sc->lock);
+                ret = ringbuffer_credit_write_block(
+                        &sc->credit, (uint8_t*)&msg, sizeof(msg));
+                pthread_mutex_unlock(&sc->lock);
+            } else if (sc->mode != BENCH_SCALE_DEQUE) {
+                pthread_mutex_lock(&sc->lock);
+                ret = ringbuffer_write_block(
+                        &sc->rb, (uint8_t*)&msg, sizeof(msg));
+                pthread_mutex_unlock(&sc->lock);
+            } else {
+                ret = ringbuffer_deque_push(
+                        &sc->deques[w->index], (uint8_t*)&msg);
+            }
+            if (ret < 0) {
+                /* >>> Full: let consumers catch up >>> */
+                sched_yield();
+            }
+        } while (ret < 0);
+    }
+
+    return 0;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void* bench_consumer(void* arg) {
+
+    bench_worker_t* w = (bench_worker_t*)arg;
+    bench_scale_t* sc = w->sc;
+    size_t total = sc->ops * sc->nprod;
+    int victim = w->index % sc->nprod;
+
+    bench_pin(sc, sc->nprod + w->index);
+
+    bench_msg_t msg;
+
+    while (__atomic_load_n(&sc->consumed, __ATOMIC_RELAXED) < total) {
+
+        int ret;
+        ringbuffer_segments_t seg;
+        if (sc->mode == BENCH_SCALE_MUTEX) {
+            pthread_mutex_lock(&sc->lock);
+            ret = ringbuffer_read_block(&sc->rb, (uint8_t*)&msg, sizeof(msg));
+            pthread_mutex_unlock(&sc->lock);
+        } else if (sc->mode == BENCH_SCALE_PIPELINE) {
+            /* Finish a block in the last stage (reading it in place), or
+             * else pass one on from the first stage */
+            pthread_mutex_lock(&sc->lock);
+            ret = ringbuffer_pipeline_get_block(&sc->pl, 1, &seg);
+            if (ret == (int)sizeof(msg)) {
+                memcpy(&msg, seg.data[0], seg.len[0]);
+                memcpy((uint8_t*)&msg + seg.len[0], seg.data[1], seg.len[1]);
+                ringbuffer_pipeline_advance_block(&sc->pl, 1);
+            } else {
+                ringbuffer_pipeline_advance_block(&sc->pl, 0);
+                ret = 0;
+            }
+            pthread_mutex_unlock(&sc->lock);
+        } else if (sc->mode == BENCH_SCALE_CREDIT) {
+            pthread_mutex_lock(&sc->lock);
+            ret = ringbuffer_credit_read_block(
+                    &sc->credit, (uint8_t*)&msg, sizeof(msg));
+            pthread_mutex_unlock(&sc->lock);
+        } else {
+            ret = ringbuffer_deque_steal(&sc->deques[victim], (uint8_t*)&msg);
+            if (ret <= 0) {
+                /* Try the next producer's deque */
+                victim = (victim + 1) % sc->nprod;
+            }
+        }
+
+        if (ret <= 0) {
+            continue;
+        }
+
+        uint64_t latency = bench_now() - msg.timestamp;
+        if (w->nsamples < w->maxsamples) {
+            w->samples[w->nsamples++] = latency;
+        }
+
+        __atomic_add_fetch(&sc->consumed, 1, __ATOMIC_RELAXED);
+    }
+
+    return 0;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static int bench_compare_u64(const void* a, const void* b) {
+
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static int bench_scale_run(bench_scale_t* sc) {
+
+    int nthreads = sc->nprod + sc->ncons;
+    bench_worker_t* w = calloc(nthreads, sizeof(bench_worker_t));
+    uint8_t* mem = malloc((size_t)BENCH_SCALE_RING_SIZE * sc->nprod);
+    sc->deques = calloc(sc->nprod, sizeof(ringbuffer_deque_t));
+
+    if (w == 0 || mem == 0 || sc->deques == 0) {
+        fprintf(stderr, "Out of memory\n");
+        return -1;
+    }
+
+    ringbuffer_init(&sc->rb, mem, BENCH_SCALE_RING_SIZE);
+    pthread_mutex_init(&sc->lock, 0);
+    ringbuffer_pipeline_init(&sc->pl, &sc->rb, sc->cursors, 2);
+    ringbuffer_credit_init(&sc->credit, &sc->rb, BENCH_SCALE_CREDIT_QUANTUM);
+    for (int i = 0; i < sc->nprod; i++) {
+        ringbuffer_deque_init(&sc->deques[i], mem + i * BENCH_SCALE_RING_SIZE,
+                BENCH_SCALE_RING_SIZE, sizeof(bench_msg_t));
+    }
+    sc->consumed = 0;
+
+    size_t total = sc->ops * sc->nprod;
+
+    for (int i = sc->nprod; i < nthreads; i++) {
+        w[i].maxsamples = (total < BENCH_SCALE_MAX_SAMPLES)
+                ? total : BENCH_SCALE_MAX_SAMPLES;
+        w[i].samples = malloc(w[i].maxsamples * sizeof(uint64_t));
+        if (w[i].samples == 0) {
+            fprintf(stderr, "Out of memory\n");
+            return -1;
+        }
+    }
+
+    bench_perf_t perf;
+    bench_perf_open(&perf);
+    bench_perf_start(&perf);
+    uint64_t t0 = bench_now();
+
+    for (int i = 0; i < nthreads; i++) {
+        w[i].sc = sc;
+        w[i].index = (i < sc->nprod) ? i : i - sc->nprod;
+        pthread_create(&w[i].thread, 0,
+                (i < sc->nprod) ? bench_producer : bench_consumer, &w[i]);
+    }
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(w[i].thread, 0);
+    }
+
+    uint64_t elapsed = bench_now() - t0;
+    bench_perf_stop(&perf);
+
+    /* Merge latency samples of all consumers */
+    size_t n = 0;
+    for (int i = sc->nprod; i < nthreads; i++) {
+        n += w[i].nsamples;
+    }
+    uint64_t* s = malloc((n + 1) * sizeof(uint64_t));
+    if (s == 0) {
+        fprintf(stderr, "Out of memory\n");
+        return -1;
+    }
+    n = 0;
+    for (int i = sc->nprod; i < nthreads; i++) {
+        memcpy(s + n, w[i].samples, w[i].nsamples * sizeof(uint64_t));
+        n += w[i].nsamples;
+    }
+    qsort(s, n, sizeof(uint64_t), bench_compare_u64);
+
+    printf("%-6s %3d %3d %12.0f msg/s   p50 %8llu ns   p99 %8llu ns"
+            "   p99.9 %8llu ns\n",
+            bench_scale_names[sc->mode], sc->nprod, sc->ncons,
+            total * 1e9 / elapsed,
+            n ? (unsigned long long)s[n / 2] : 0ull,
+            n ? (unsigned long long)s[n * 99 / 100] : 0ull,
+            n ? (unsigned long long)s[n * 999 / 1000] : 0ull);
+
+    bench_perf_close(&perf, (double)total);
+
+    free(s);
+    for (int i = sc->nprod; i < nthreads; i++) {
+        free(w[i].samples);
+    }
+    pthread_mutex_destroy(&sc->lock);
+    free(sc->deques);
+    free(mem);
+    free(w);
+
+    return 0;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static int bench_scale(int maxthreads, size_t ops, const char* cpulist) {
+
+    /* Parse list of CPUs to pin threads to (e.g. "0,32,1,33") */
+    int cpus[1024];
+    int ncpus = 0;
+    while (cpulist != 0 && *cpulist != '\0' && ncpus < 1024) {
+        char* end;
+        long cpu = strtol(cpulist, &end, 10);
+        if (end == cpulist || cpu < 0) {
+            fprintf(stderr, "Invalid CPU list\n");
+            return -1;
+        }
+        cpus[ncpus++] = (int)cpu;
+        cpulist = (*end == ',') ? end + 1 : end;
+    }
+
+    printf("mode   prod cons   throughput        latency percentiles\n");
+
+    for (int m = 0; m < BENCH_NUM_SCALE_MODES; m++) {
+        for (int p = 1; p <= maxthreads; p *= 2) {
+            for (int c = 1; c <= maxthreads; c *= 2) {
+
+                bench_scale_t sc;
+                sc.mode = m;
+                sc.nprod = p;
+                sc.ncons = c;
+                sc.ops = ops;
+                sc.cpus = cpus;
+                sc.ncpus = ncpus;
+
+                if (bench_scale_run(&sc) < 0) {
+                    return -1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+/*
+ * Corpora of the search benchmark
+ */
+#define BENCH_CORPUS_HTTP       0
+#define BENCH_CORPUS_RARE       1
+#define BENCH_CORPUS_FREQUENT   2
+#define BENCH_CORPUS_NEARMATCH  3
+
+static const char* bench_corpus_names[] = {
+        "http", "rare-first", "freq-first", "near-match" };
+
+#define BENCH_NUM_CORPORA 4
+
+
+/*
+ * Placements of the match relative to the ringbuffer's wrap point
+ */
+static const char* bench_place_names[] = { "before", "across", "after" };
+
+#define BENCH_NUM_PLACES 3
+
+
+/* Longest search pattern */
+#define BENCH_MAX_PATTERN 256
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void bench_corpus_fill(int corpus, uint8_t* data, size_t len) {
+
+    static const char* lines[] = {
+        "GET /index.html HTTP/1.1\r\n", "Host: www.example.com\r\n",
+        "User-Agent: Mozilla/5.0 (compatible)\r\n", "Accept: */*\r\n",
+        "Accept-Encoding: gzip, deflate\r\n", "Connection: keep-alive\r\n",
+        "Cookie: session=0123456789abcdef; theme=dark\r\n", "\r\n" };
+
+    size_t i = 0;
+    size_t line = 0;
+
+    switch (corpus) {
+    case BENCH_CORPUS_HTTP:
+        /* Request headers (never containing 'X') */
+        while (i < len) {
+            const char* l = lines[line++ % (sizeof(lines) / sizeof(lines[0]))];
+            for (; *l != '\0' && i < len; l++) {
+                data[i++] = (uint8_t)*l;
+            }
+        }
+        break;
+    case BENCH_CORPUS_RARE:
+        /* Random bytes below 0x80 */
+        for (; i < len; i++) {
+            data[i] = (uint8_t)(rand() & 0x7F);
+        }
+        break;
+    case BENCH_CORPUS_FREQUENT:
+        /* Mostly zeros, otherwise random bytes below 0x80 */
+        for (; i < len; i++) {
+            data[i] = (rand() % 10 < 9) ? 0 : (uint8_t)(rand() & 0x7F);
+        }
+        break;
+    default:
+        /* Nothing but 'a' */
+        memset(data, 'a', len);
+        break;
+    }
+}
+
+
+/*
+ * Generates a pattern that does not occur in <corpus> on its own.
+ * ___________________________________________________________________________
+ */
+static void bench_pattern_fill(int corpus, uint8_t* pattern, size_t len) {
+
+    static const char hex[] = "0123456789abcdef";
+    static const char prefix[] = "X-Request-Id: ";
+
+    for (size_t i = 0; i < len; i++) {
+        switch (corpus) {
+        case BENCH_CORPUS_HTTP:
+            /* A header line the corpus doesn't have */
+            pattern[i] = (i < sizeof(prefix) - 1)
+                    ? (uint8_t)prefix[i] : (uint8_t)hex[rand() & 0x0F];
+            break;
+        case BENCH_CORPUS_RARE:
+            /* Starts with a byte that never occurs in the corpus */
+            pattern[i] = (i == 0) ? 0xFF : (uint8_t)(rand() & 0x7F);
+            break;
+        case BENCH_CORPUS_FREQUENT:
+            /* Starts with the most frequent byte of the corpus */
+            pattern[i] = (i == 0) ? 0x00 : (uint8_t)(0x80 | rand());
+            break;
+        default:
+            /* All but the last byte match everywhere */
+            pattern[i] = (i + 1 < len) ? 'a' : 'b';
+            break;
+        }
+    }
+}
+
+
+/*
+ * A task handed to a thread by the parallel benchmark's runner
+ */
+typedef struct {
+
+    ringbuffer_task_t task;
+    void* arg;
+    size_t index;
+
+} bench_task_t;
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void* bench_task_thread(void* arg) {
+
+    bench_task_t* t = (bench_task_t*)arg;
+    t->task(t->arg, t->index);
+
+    return 0;
+}
+
+
+/*
+ * Runner for the parallel benchmark: one thread per task
+ * ___________________________________________________________________________
+ */
+static int bench_runner(void* pool,
+        ringbuffer_task_t task, void* arg, size_t ntasks) {
+
+    pthread_t threads[RINGBUFFER_PARALLEL_MAX_CHUNKS];
+    bench_task_t tasks[RINGBUFFER_PARALLEL_MAX_CHUNKS];
+
+    (void)pool;
+
+    for (size_t i = 0; i < ntasks; i++) {
+        tasks[i].task = task;
+        tasks[i].arg = arg;
+        tasks[i].index = i;
+        if (pthread_create(&threads[i], 0, bench_task_thread, &tasks[i]) != 0) {
+            /* Run it here instead */
+            threads[i] = pthread_self();
+            task(arg, i);
+        }
+    }
+
+    for (size_t i = 0; i < ntasks; i++) {
+        if (!pthread_equal(threads[i], pthread_self())) {
+            pthread_join(threads[i], 0);
+        }
+    }
+
+    return 0;
+}
+
+
+/*
+ * Searches covered by the search benchmark
+ */
+#define BENCH_SEARCH_FIND       0
+#define BENCH_SEARCH_RFIND      1
+#define BENCH_SEARCH_FIND_ANY   2
+#define BENCH_SEARCH_PARALLEL   3
+
+static const char* bench_search_names[] = {
+        "find", "rfind", "find_any", "find_par" };
+
+#define BENCH_NUM_SEARCHES 4
+
+
+/* Number of chunks (threads) of the parallel search */
+#define BENCH_SEARCH_THREADS 4
+
+
+/*
+ * Runs search <search> for <pattern> (or any of its bytes, see <set>) on
+ * ringbuffer <rb>.
+ * ___________________________________________________________________________
+ */
+static int bench_search(int search, ringbuffer_t* rb,
+        const uint8_t* pattern, size_t plen, const ringbuffer_byteset_t* set) {
+
+    switch (search) {
+    case BENCH_SEARCH_FIND:
+        return ringbuffer_find(rb, 0, (uint8_t*)pattern, plen);
+    case BENCH_SEARCH_RFIND:
+        return ringbuffer_rfind(rb, 0, pattern, plen);
+    case BENCH_SEARCH_FIND_ANY:
+        return ringbuffer_find_any(rb, 0, set);
+    default:
+        return ringbuffer_find_parallel(rb, 0, pattern, plen,
+                BENCH_SEARCH_THREADS, bench_runner, 0);
+    }
+}
+
+
+/*
+ * Runs the baseline of search <search>: a single-threaded ringbuffer_find()
+ * for the parallel search, otherwise the corresponding libc search on a
+ * linearized copy of the content (<linear>, <size> bytes).
+ * ___________________________________________________________________________
+ */
+static int bench_search_baseline(int search, ringbuffer_t* rb,
+        uint8_t* linear, size_t size, const uint8_t* pattern, size_t plen) {
+
+    if (search == BENCH_SEARCH_PARALLEL) {
+        return ringbuffer_find(rb, 0, (uint8_t*)pattern, plen);
+    }
+
+    ringbuffer_peek(rb, linear, size);
+
+    if (search == BENCH_SEARCH_FIND) {
+        uint8_t* m = memmem(linear, size, pattern, plen);
+        return (m != 0) ? (int)(m - linear) : -1;
+    }
+
+    if (search == BENCH_SEARCH_RFIND) {
+        /* Candidates for the first byte from the end */
+        size_t n = size - plen + 1;
+        uint8_t* m;
+        while ((m = memrchr(linear, pattern[0], n)) != 0) {
+            if (memcmp(m, pattern, plen) == 0) {
+                return (int)(m - linear);
+            }
+            n = m - linear;
+        }
+        return -1;
+    }
+
+    /* Any byte of the pattern: look up each byte in a table */
+    uint8_t member[256] = { 0 };
+    for (size_t j = 0; j < plen; j++) {
+        member[pattern[j]] = 1;
+    }
+    for (size_t j = 0; j < size; j++) {
+        if (member[linear[j]]) {
+            return (int)j;
+        }
+    }
+
+    return -1;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static int bench_find(size_t size, int repetitions) {
+
+    uint8_t* mem = malloc(size);
+    uint8_t* corpus = malloc(size);
+    uint8_t* linear = malloc(size);
+
+    if (mem == 0 || corpus == 0 || linear == 0
+            || size < 4 * BENCH_MAX_PATTERN) {
+        fprintf(stderr, "Out of memory (or ring size too small)\n");
+        return -1;
+    }
+
+    printf("search   corpus      pattern placement        ringbuffer    "
+            "     baseline   speedup\n");
+
+    for (int s = 0; s < BENCH_NUM_SEARCHES; s++) {
+        for (int c = 0; c < BENCH_NUM_CORPORA; c++) {
+            for (size_t plen = 1; plen <= BENCH_MAX_PATTERN; plen *= 2) {
+                for (int p = 0; p < BENCH_NUM_PLACES; p++) {
+
+                    uint8_t pattern[BENCH_MAX_PATTERN];
+                    bench_corpus_fill(c, corpus, size);
+                    bench_pattern_fill(c, pattern, plen);
+
+                    /* The ringbuffer wraps at half of its content */
+                    size_t wrap = size / 2;
+                    size_t pos = (p == 0) ? wrap / 2
+                            : (p == 1) ? wrap - plen / 2 : wrap + wrap / 2;
+                    memcpy(corpus + pos, pattern, plen);
+
+                    ringbuffer_t rb;
+                    ringbuffer_init(&rb, mem, size);
+                    ringbuffer_write(&rb, corpus, wrap);
+                    ringbuffer_discard(&rb, wrap);
+                    ringbuffer_write(&rb, corpus, size);
+
+                    ringbuffer_byteset_t set;
+                    ringbuffer_byteset_init(&set, pattern, plen);
+
+                    int found = 0;
+                    int expected = 0;
+
+                    uint64_t t0 = bench_now();
+                    for (int r = 0; r < repetitions; r++) {
+                        found = bench_search(s, &rb, pattern, plen, &set);
+                    }
+                    uint64_t t1 = bench_now();
+                    for (int r = 0; r < repetitions; r++) {
+                        expected = bench_search_baseline(
+                                s, &rb, linear, size, pattern, plen);
+                    }
+                    uint64_t t2 = bench_now();
+
+                    if (found != expected) {
+                        fprintf(stderr, "Mismatch: %s = %d, baseline = %d\n",
+                                bench_search_names[s], found, expected);
+                        return -1;
+                    }
+
+                    double tf = (double)(t1 - t0) / repetitions;
+                    double tm = (double)(t2 - t1) / repetitions;
+
+                    printf("%-8s %-11s %7zu %-9s %12.0f ns %12.0f ns "
+                            "%8.2fx\n", bench_search_names[s],
+                            bench_corpus_names[c], plen, bench_place_names[p],
+                            tf, tm, tf > 0 ? tm / tf : 0.0);
+                }
+            }
+        }
+    }
+
+    free(mem);
+    free(corpus);
+    free(linear);
+
+    return 0;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static int bench_parallel(size_t size, int maxthreads) {
+
+    uint8_t* mem = malloc(size);
+    uint8_t* corpus = malloc(size);
+    uint8_t pattern[16];
+
+    if (mem == 0 || corpus == 0 || size < 2 * sizeof(pattern)) {
+        fprintf(stderr, "Out of memory (or ring size too small)\n");
+        return -1;
+    }
+
+    /* A full ringbuffer wrapping at half of its content, with a pattern
+     * that only occurs right at the end */
+    bench_corpus_fill(BENCH_CORPUS_RARE, corpus, size);
+    bench_pattern_fill(BENCH_CORPUS_RARE, pattern, sizeof(pattern));
+    memcpy(corpus + size - sizeof(pattern), pattern, sizeof(pattern));
+
+    ringbuffer_t rb;
+    ringbuffer_init(&rb, mem, size);
+    ringbuffer_write(&rb, corpus, size / 2);
+    ringbuffer_discard(&rb, size / 2);
+    ringbuffer_write(&rb, corpus, size);
+
+    printf("threads        find     GB/s       crc32     GB/s\n");
+
+    for (int threads = 1; threads <= maxthreads
+            && threads <= RINGBUFFER_PARALLEL_MAX_CHUNKS; threads *= 2) {
+
+        uint32_t crc;
+
+        uint64_t t0 = bench_now();
+        int found = ringbuffer_find_parallel(&rb, 0, pattern, sizeof(pattern),
+                threads, bench_runner, 0);
+        uint64_t t1 = bench_now();
+        ringbuffer_crc32_parallel(&rb, 0, size, &crc,
+                threads, bench_runner, 0);
+        uint64_t t2 = bench_now();
+
+        if (found != (int)(size - sizeof(pattern))) {
+            fprintf(stderr, "Pattern not found at the end (%d)\n", found);
+            return -1;
+        }
+
+        printf("%7d %8.2f ms %8.2f %8.2f ms %8.2f\n", threads,
+                (t1 - t0) / 1e6, (double)size / (t1 - t0),
+                (t2 - t1) / 1e6, (double)size / (t2 - t1));
+    }
+
+    free(mem);
+    free(corpus);
+
+    return 0;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void bench_usage(const char* prog) {
+
+    fprintf(stderr,
+            "Usage:\n"
+            "  %s [options] replay <trace> "
+            "[checked|nocheck|compact] [repetitions]\n"
+            "  %s [options] scale "
+            "[max-threads] [messages-per-producer] [cpu-list]\n"
+            "  %s [options] find [ring-size] [repetitions]\n"
+            "  %s [options] parallel [ring-size] [max-threads]\n"
+            "Options:\n"
+            "  -p           report hardware performance counters per operation\n"
+            "  -r <config>  additionally count raw PMU event <config> (hex)\n",
+            prog, prog, prog, prog);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int main(int argc, char* argv[]) {
+
+    const char* prog = argv[0];
+
+    /* Parse options */
+    while (argc >= 2 && argv[1][0] == '-') {
+        if (strcmp(argv[1], "-p") == 0) {
+            bench_perf_enabled = 1;
+        } else if (strcmp(argv[1], "-r") == 0 && argc >= 3) {
+            bench_perf_enabled = 1;
+            bench_perf_raw = strtoull(argv[2], 0, 16);
+            argc--;
+            argv++;
+        } else {
+            bench_usage(prog);
+            return 1;
+        }
+        argc--;
+        argv++;
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "replay") == 0) {
+
+        int mode = (argc >= 4) ? bench_parse_mode(argv[3]) : -1;
+        int repetitions = (argc >= 5) ? atoi(argv[4]) : 10;
+
+        if ((argc >= 4 && mode < 0) || repetitions <= 0) {
+            bench_usage(prog);
+            return 1;
+        }
+
+        return bench_replay(argv[2], mode, repetitions) < 0 ? 1 : 0;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "scale") == 0) {
+
+        int maxthreads = (argc >= 3) ? atoi(argv[2]) : 4;
+        long ops = (argc >= 4) ? atol(argv[3]) : 100000;
+
+        if (maxthreads <= 0 || ops <= 0) {
+            bench_usage(prog);
+            return 1;
+        }
+
+        return bench_scale(maxthreads, ops,
+                (argc >= 5) ? argv[4] : 0) < 0 ? 1 : 0;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "find") == 0) {
+
+        long size = (argc >= 3) ? atol(argv[2]) : 1 << 20;
+        int repetitions = (argc >= 4) ? atoi(argv[3]) : 20;
+
+        if (size <= 0 || repetitions <= 0) {
+            bench_usage(prog);
+            return 1;
+        }
+
+        return bench_find(size, repetitions) < 0 ? 1 : 0;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "parallel") == 0) {
+
+        long size = (argc >= 3) ? atol(argv[2]) : 1 << 28;
+        int maxthreads = (argc >= 4) ? atoi(argv[3]) : 8;
+
+        if (size <= 0 || maxthreads <= 0) {
+            bench_usage(prog);
+            return 1;
+        }
+
+        return bench_parallel(size, maxthreads) < 0 ? 1 : 0;
+    }
+
+    bench_usage(prog);
+    return 1;
+}
@@ -25,6 +25,360 @@
 
 #include "ringbuffer.h"
 #include <string.h>
+#include <assert.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+
+#ifdef RINGBUFFER_TRACE
+
+/*
+ * Trace hook and its context (see ringbuffer_set_trace_hook). Both are
+ * accessed atomically as the hook may be installed while other threads
+ * operate on ringbuffers; the context is published before the hook.
+ */
+static ringbuffer_trace_hook_t ringbuffer_trace_hook = 0;
+static void* ringbuffer_trace_ctx = 0;
+
+#define RINGBUFFER_TRACE_OP(rb, op, len, aux)                                 \
+    do {                                                                      \
+        ringbuffer_trace_hook_t hook_ =                                       \
+                __atomic_load_n(&ringbuffer_trace_hook, __ATOMIC_ACQUIRE);    \
+        if (hook_ != 0) {                                                     \
+            hook_(__atomic_load_n(&ringbuffer_trace_ctx, __ATOMIC_RELAXED),   \
+                    rb, op, len, aux);                                        \
+        }                                                                     \
+    } while (0)
+
+#else
+
+#define RINGBUFFER_TRACE_OP(rb, op, len, aux) do { } while (0)
+
+#endif
+
+
+/*
+ * Returns the offset of the first occurrence of <byte> within <len> bytes of
+ * content starting at <offset>, or -1 if there is none.
+ */
+static int ringbuffer_find_byte_range(
+        ringbuffer_t* rb, size_t offset, size_t len, uint8_t byte);
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void ringbuffer_copy_stream(
+        uint8_t* dst, const uint8_t* src, size_t len) {
+
+#if defined(__SSE2__)
+    /* Copy unaligned head regularly such that <dst> is 16-byte aligned */
+    size_t head = (size_t)(-(uintptr_t)dst & 15);
+    if (head > len) {
+        head = len;
+    }
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    len -= head;
+
+    /* Copy 64 bytes per iteration using non-temporal stores */
+    while (len >= 64) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + 0));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + 32));
+        __m128i d = _mm_loadu_si128((const __m128i*)(src + 48));
+        _mm_stream_si128((__m128i*)(dst + 0), a);
+        _mm_stream_si128((__m128i*)(dst + 16), b);
+        _mm_stream_si128((__m128i*)(dst + 32), c);
+        _mm_stream_si128((__m128i*)(dst + 48), d);
+        dst += 64;
+        src += 64;
+        len -= 64;
+    }
+
+    /* Make non-temporal stores visible before the indices are updated */
+    _mm_sfence();
+#endif
+
+    /* Copy remaining tail (or everything without SSE2) */
+    memcpy(dst, src, len);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void ringbuffer_copy_in(
+        uint8_t* dst, const uint8_t* src, size_t len, int stream) {
+
+    if (stream) {
+        /* >>> Large write the consumer won't read soon: bypass cache >>> */
+        ringbuffer_copy_stream(dst, src, len);
+    } else {
+        memcpy(dst, src, len);
+    }
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void ringbuffer_write_unchecked(
+        ringbuffer_t* rb, const uint8_t* data, size_t len) {
+
+    /* Decide once for the whole write whether to bypass the cache */
+    size_t threshold =
+            __atomic_load_n(&rb->stream_threshold, __ATOMIC_RELAXED);
+    int stream = (threshold != 0 && len >= threshold);
+
+    /* Determine the amount of data that can be written linearly */
+    size_t linlen = (size_t)(rb->size - rb->iw);
+
+    if (len < linlen) {
+        /* >>> The whole write request can be performed linearly >>> */
+
+        /* Copy data to ringbuffer linearly */
+        ringbuffer_copy_in(rb->buffer + rb->iw, data, len, stream);
+
+        /* Advance write index */
+        rb->iw += len;
+
+    } else {
+        /* >>> The write request reaches (or wraps around) the end >>> */
+
+        /* Copy first part of data linearly */
+        ringbuffer_copy_in(rb->buffer + rb->iw, data, linlen, stream);
+
+        /* Move write index such that it reflects the correct
+         * state AFTER all data has been written (implicit wrap) */
+        rb->iw = len - linlen;
+
+        /* Copy remaining data linearly to beginning of ringbuffer */
+        ringbuffer_copy_in(rb->buffer, data + linlen, rb->iw, stream);
+
+    }
+
+    /* <len> bytes have been written to the ringbuffer */
+    rb->len += len;
+    rb->written += len;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void ringbuffer_peek_unchecked(
+        ringbuffer_t* rb, size_t offset, uint8_t* data, size_t len) {
+
+    /* the "virtual" read index of the ringbuffer's
+     * after considering data to disregard (offset) */
+    size_t vir = rb->ir + offset;
+    if (vir >= rb->size) {
+        vir -= rb->size;
+    }
+
+    /* assuming read index never exceeds size */
+    size_t linlen = (size_t)(rb->size - vir);
+
+    if (len <= linlen) {
+
+        /* copy data until end of buffer */
+        memcpy(data, rb->buffer + vir, len);
+
+    } else {
+
+        /* copy data until end of buffer */
+        memcpy(data, rb->buffer + vir, linlen);
+
+        /* copy remaining data to beginning of buffer */
+        memcpy(data + linlen, rb->buffer, len - linlen);
+
+    }
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void ringbuffer_discard_unchecked(ringbuffer_t* rb, size_t len) {
+
+    rb->len -= len;
+
+    /* assuming read index never exceeds size */
+    size_t linlen = (size_t)(rb->size - rb->ir);
+
+    if (len < linlen) {
+        /* advance read index */
+        rb->ir += len;
+    } else {
+        /* read index (implicitly) wrapped */
+        rb->ir = len - linlen;
+    }
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void ringbuffer_write_length(ringbuffer_t* rb, size_t len) {
+
+    if ((size_t)(rb->size - rb->iw) <= sizeof(size_t)) {
+        /* >>> Length field reaches the end: take the slow path >>> */
+        ringbuffer_write_unchecked(rb, (uint8_t*)&len, sizeof(size_t));
+        return;
+    }
+
+    /* Fixed-size copy compiles to a single store */
+    memcpy(rb->buffer + rb->iw, &len, sizeof(size_t));
+
+    /* Advance write index (cannot reach the end, see above) */
+    rb->iw += sizeof(size_t);
+    rb->len += sizeof(size_t);
+    rb->written += sizeof(size_t);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static int ringbuffer_peek_length(
+        ringbuffer_t* rb, size_t offset, size_t* len) {
+
+    if (offset + sizeof(size_t) > rb->len) {
+        /* >>> No length field at offset >>> */
+        return -1;
+    }
+
+    /* the read index after considering the offset */
+    size_t vir = rb->ir + offset;
+    if (vir >= rb->size) {
+        vir -= rb->size;
+    }
+
+    if ((size_t)(rb->size - vir) < sizeof(size_t)) {
+        /* >>> Length field wraps: take the slow path >>> */
+        ringbuffer_peek_unchecked(rb, offset, (uint8_t*)len, sizeof(size_t));
+    } else {
+        /* Fixed-size copy compiles to a single load */
+        memcpy(len, rb->buffer + vir, sizeof(size_t));
+    }
+
+    return sizeof(size_t);
+}
+
+
+/*
+ * Prefetches (for reading) the cache lines holding <len> bytes of content
+ * starting at <offset>.
+ * ___________________________________________________________________________
+ */
+static void ringbuffer_prefetch(ringbuffer_t* rb, size_t offset, size_t len) {
+
+#if defined(__GNUC__) && RINGBUFFER_PREFETCH_DISTANCE >= 0
+    /* Cache line size assumed for stepping through the region */
+    const uintptr_t line = 64;
+
+    if (offset >= rb->len) {
+        /* >>> Nothing to prefetch >>> */
+        return;
+    }
+    if (len > rb->len - offset) {
+        len = rb->len - offset;
+    }
+
+    /* the read index of the region */
+    size_t vir = rb->ir + offset;
+    if (vir >= rb->size) {
+        vir -= rb->size;
+    }
+
+    /* Split the region at the end of the buffer */
+    size_t linlen = (size_t)(rb->size - vir);
+    const uint8_t* start[2] = { rb->buffer + vir, rb->buffer };
+    size_t n[2] = { len, 0 };
+    if (len > linlen) {
+        n[0] = linlen;
+        n[1] = len - linlen;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        /* Start at the line boundary at or before the region such that
+         * the region's last line is not missed (prefetches never fault) */
+        uintptr_t a = (uintptr_t)start[i] & ~(line - 1);
+        for (; n[i] > 0 && a < (uintptr_t)start[i] + n[i]; a += line) {
+            __builtin_prefetch((const void*)a, 0, 3);
+        }
+    }
+#else
+    (void)rb;
+    (void)offset;
+    (void)len;
+#endif
+}
+
+
+/*
+ * Prefetches the length field and the start of the payload of the block (or
+ * frame) at <offset>.
+ * ___________________________________________________________________________
+ */
+static void ringbuffer_prefetch_block(ringbuffer_t* rb, size_t offset) {
+
+#if RINGBUFFER_PREFETCH_DISTANCE >= 0
+    ringbuffer_prefetch(rb, offset,
+            sizeof(size_t) + RINGBUFFER_PREFETCH_DISTANCE);
+#else
+    (void)rb;
+    (void)offset;
+#endif
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_set_stream_threshold(ringbuffer_t* rb, size_t threshold) {
+
+    if (rb == 0) {
+        /* >>> Invalid pointer to ringbuffer >>> */
+        return -1;
+    }
+
+#if defined(__SSE2__)
+    __atomic_store_n(&rb->stream_threshold, threshold, __ATOMIC_RELAXED);
+    return 0;
+#else
+    /* >>> No non-temporal stores available >>> */
+    return (threshold == 0) ? 0 : -1;
+#endif
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_set_trace_hook(ringbuffer_trace_hook_t hook, void* ctx) {
+
+#ifdef RINGBUFFER_TRACE
+    /* Remove the old hook before switching contexts, then publish the
+     * context before the new hook */
+    __atomic_store_n(&ringbuffer_trace_hook, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&ringbuffer_trace_ctx, ctx, __ATOMIC_RELAXED);
+    __atomic_store_n(&ringbuffer_trace_hook, hook, __ATOMIC_RELEASE);
+    return 0;
+#else
+    /* >>> Tracing not compiled in >>> */
+    (void)ctx;
+    return (hook == 0) ? 0 : -1;
+#endif
+}
 
 
 /*
@@ -41,6 +395,8 @@ int ringbuffer_init(ringbuffer_t* rb, uint8_t* mem, size_t memlen) {
     /* Set memory */
     rb->buffer = mem;
     rb->size = memlen;
+    rb->written = 0;
+    rb->stream_threshold = RINGBUFFER_STREAM_THRESHOLD;
 
     /* Reset read/write pointers */
     return ringbuffer_clear(rb);
@@ -58,6 +414,8 @@ int ringbuffer_clear(ringbuffer_t* rb) {
         return -1;
     }
 
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_CLEAR, 0, 0);
+
     /* Reset length and read/write indices */
     rb->len = 0;
     rb->iw = 0;
@@ -112,6 +470,8 @@ int ringbuffer_write(ringbuffer_t* rb, const uint8_t* data, size_t len) {
         return -1;
     }
 
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_WRITE, len, 0);
+
     /* Don't write more data than the ringbuffer can hold */
     size_t space = (size_t)(rb->size - rb->len);
     if (len > space) {
@@ -120,40 +480,7 @@ int ringbuffer_write(ringbuffer_t* rb, const uint8_t* data, size_t len) {
         len = space;
     }
 
-    /* Determine the amount of data that can be written linearly */
-    size_t linlen = (size_t)(rb->size - rb->iw);
-
-    if (len <= linlen) {
-        /* >>> The whole write request can be performed linearly >>> */
-
-        /* Copy data to ringbuffer linearly */
-        memcpy(rb->buffer + rb->iw, data, len);
-
-        /* Advance write index */
-        rb->iw += len;
-        if (len == linlen) {
-            /* >>> rb->iw == rb->size >>> */
-            /* Wrap write index */
-            rb->iw = 0;
-        }
-
-    } else {
-        /* >>> The write request requires two steps >>> */
-
-        /* Copy first part of data linearly */
-        memcpy(rb->buffer + rb->iw, data, linlen);
-
-        /* Move write index such that it reflects the correct
-         * state AFTER all data has been written (implicit wrap) */
-        rb->iw = len - linlen;
-
-        /* Copy remaining data linearly to beginning of ringbuffer */
-        memcpy(rb->buffer, data + linlen, rb->iw);
-
-    }
-
-    /* <len> bytes have been written to the ringbuffer */
-    rb->len += len;
+    ringbuffer_write_unchecked(rb, data, len);
 
     /* Return the number of bytes writte to ringbuffer */
     return len;
@@ -171,46 +498,15 @@ int ringbuffer_write_all(ringbuffer_t* rb, const uint8_t* data, size_t len) {
         return -1;
     }
 
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_WRITE_ALL, len, 0);
+
     /* Make sure all data can be written to ringbuffer */
     if (len > (size_t)(rb->size - rb->len)) {
         /* >>> Ringbuffer too small to write data >>> */
         return -1;
     }
 
-    /* Determine the amount of data that can be written linearly */
-    size_t linlen = (size_t)(rb->size - rb->iw);
-
-    if (len <= linlen) {
-        /* >>> The whole write request can be performed linearly >>> */
-
-        /* Copy data to ringbuffer linearly */
-        memcpy(rb->buffer + rb->iw, data, len);
-
-        /* Advance write index */
-        rb->iw += len;
-        if (len == linlen) {
-            /* >>> rb->iw == rb->size >>> */
-            /* Wrap write index */
-            rb->iw = 0;
-        }
-
-    } else {
-        /* >>> The write request requires two steps >>> */
-
-        /* Copy first part of data linearly */
-        memcpy(rb->buffer + rb->iw, data, linlen);
-
-        /* Move write index such that it reflects the correct
-         * state AFTER all data has been written (implicit wrap) */
-        rb->iw = len - linlen;
-
-        /* Copy remaining data linearly to beginning of ringbuffer */
-        memcpy(rb->buffer, data + linlen, rb->iw);
-
-    }
-
-    /* <len> bytes have been written to the ringbuffer */
-    rb->len += len;
+    ringbuffer_write_unchecked(rb, data, len);
 
     /* Return the number of bytes writte to ringbuffer */
     return len;
@@ -228,6 +524,8 @@ int ringbuffer_read(ringbuffer_t* rb, uint8_t* data, size_t len) {
         return -1;
     }
 
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_READ, len, 0);
+
     /* Don't read more than there is data available in the ringbuffer */
     if (len > rb->len) {
         /* >>> Reqeusted to read more data than available >>> */
@@ -235,40 +533,33 @@ int ringbuffer_read(ringbuffer_t* rb, uint8_t* data, size_t len) {
         len = rb->len;
     }
 
-    /* Determine the amount of data that can be read linearly */
-    size_t linlen = (size_t)(rb->size - rb->ir);
-
-    if (len <= linlen) {
-
-        /* Copy data until end of buffer */
-        memcpy(data, rb->buffer + rb->ir, len);
+    ringbuffer_peek_unchecked(rb, 0, data, len);
+    ringbuffer_discard_unchecked(rb, len);
 
-        /* Advance read index */
-        rb->ir += len;
-        if (len == linlen) {
-            /* >>> rb->ir == rb->size >>> */
-            /* Wrap read index */
-            rb->ir = 0;
-        }
+    /* Return the number of bytes that have actually been read */
+    return len;
+}
 
-    } else {
 
-        /* copy data until end of buffer (assuming
-         * write index never exceeds size) */
-        memcpy(data, rb->buffer + rb->ir, linlen);
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_peek(ringbuffer_t* rb, uint8_t* data, size_t len) {
 
-        /* read index implicitly wrapped */
-        rb->ir = len - linlen;
+    if (rb == 0 || data == 0) {
+        /* >>> Invalid pointer to ringbuffer or data buffer >>> */
+        return -1;
+    }
 
-        /* copy remaining data to beginning of buffer */
-        memcpy(data + linlen, rb->buffer, rb->ir);
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_PEEK, len, 0);
 
+    /* Make sure not to read more data than there is available */
+    if (len > rb->len) {
+        len = rb->len;
     }
 
-    /* <len> bytes have been read from the ringbuffer */
-    rb->len -= len;
+    ringbuffer_peek_unchecked(rb, 0, data, len);
 
-    /* Return the number of bytes that have actually been read */
     return len;
 }
 
@@ -276,69 +567,605 @@ int ringbuffer_read(ringbuffer_t* rb, uint8_t* data, size_t len) {
 /*
  * ___________________________________________________________________________
  */
-int ringbuffer_peek(ringbuffer_t* rb, uint8_t* data, size_t len) {
+int ringbuffer_peek_offset(
+        ringbuffer_t* rb, size_t offset, uint8_t* data, size_t len) {
 
     if (rb == 0 || data == 0) {
         /* >>> Invalid pointer to ringbuffer or data buffer >>> */
         return -1;
     }
 
-    /* Make sure not to read more data than there is available */
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_PEEK, len, offset);
+
+    /* the "virtual" length of the ringbuffer's content
+     * after considering data to disregard (offset) */
+    size_t vLen = (offset < rb->len) ? (rb->len - offset) : 0;
+
+    /* don't read more than there is data */
+    if (len > vLen) {
+        len = vLen;
+    }
+
+    if (len > 0) {
+        ringbuffer_peek_unchecked(rb, offset, data, len);
+    }
+
+    return len;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_find(
+        ringbuffer_t* rb, size_t offset, uint8_t* data, size_t len) {
+
+    if (rb == 0 || data == 0) {
+        /* >>> Invalid pointer to ringbuffer or data buffer >>> */
+        return -1;
+    }
+
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_FIND, len, offset);
+
+    if (len == 0 || len > rb->len || offset > rb->len - len) {
+        /* >>> Invalid search pattern or nothing to search >>> */
+        return -1;
+    }
+
+    ringbuffer_segments_t seg;
+    ringbuffer_get_segments(rb, offset, rb->len - offset, &seg);
+
+    /* The number of offsets a match may start at */
+    size_t n = rb->len - len - offset + 1;
+
+    for (int i = 0; i < 2 && n > 0; i++) {
+
+        /* Candidates starting within this linear region */
+        size_t m = (seg.len[i] < n) ? seg.len[i] : n;
+        const uint8_t* p = seg.data[i];
+        const uint8_t* end = seg.data[i] + m;
+
+        /* Hop from candidate to candidate by the pattern's first byte */
+        while (p < end && (p = memchr(p, data[0], (size_t)(end - p))) != 0) {
+
+            size_t j = (size_t)(p - seg.data[i]);
+            size_t tail = seg.len[i] - j;
+
+            if (tail >= len) {
+                /* Window is linear: compare in place */
+                if (memcmp(p, data, len) == 0) {
+                    /* >>> Found at offset! >>> */
+                    return offset + j;
+                }
+            } else if (memcmp(p, data, tail) == 0
+                    && memcmp(seg.data[1], data + tail, len - tail) == 0) {
+                /* >>> Found at offset (window wraps around)! >>> */
+                return offset + j;
+            }
+
+            p++;
+        }
+
+        offset += seg.len[i];
+        n -= m;
+    }
+
+    /* >>> Search pattern not found >>> */
+    return -1;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_discard(ringbuffer_t* rb, size_t len) {
+
+    if (rb == 0) {
+        /* >>> Invalid pointer to ringbuffer or data buffer >>> */
+        return -1;
+    }
+
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_DISCARD, len, 0);
+
+    /* don't discard more than there is data */
     if (len > rb->len) {
         len = rb->len;
     }
 
-    /* Determine the length of data readable without wrap-
-     * around (assuming read index never exceeds size) */
-    size_t linlen = rb->size - rb->ir;
+    ringbuffer_discard_unchecked(rb, len);
 
-    if (len <= linlen) {
+    return len;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_write_block(ringbuffer_t* rb, const uint8_t* block, size_t len) {
+
+    /* Sanity check: make sure input pointers are ok */
+    if (rb == 0 || block == 0) {
+        /* >>> Invalid pointer to ringbuffer or block data to write >>> */
+        return 0;
+    }
+
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_WRITE_BLOCK, len, 0);
+
+    /* only write block if there is enough space for
+     * the full block (assuming len never exceeds size) */
+    size_t space = (size_t)(rb->size - rb->len);
+
+    if ((len + sizeof(size_t)) > space) {
+        /* >>> No enough space to write block >>> */
+        return -1;
+    }
+
+    /* Write block length and data (cannot fail after the check above) */
+    ringbuffer_write_length(rb, len);
+    ringbuffer_write_unchecked(rb, block, len);
+
+    /* Return the total number of bytes written to the ringbuffer */
+    return len + sizeof(size_t);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_read_block(ringbuffer_t* rb, uint8_t* block, size_t len) {
+
+    if (rb == 0 || block == 0) {
+        return 0;
+    }
+
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_READ_BLOCK, len, 0);
+
+    /* Read the Block length */
+    size_t bl = 0;
+    if (ringbuffer_peek_length(rb, 0, &bl) != sizeof(size_t)) {
+        /* >>> Invalid block >>> */
+        return 0;
+    }
+
+    /* Sanity check: make sure that ...
+     *  -> the apparent payload is not longer than there is data
+     *  -> the user-provided buffer is sufficiently large to hold the payload
+     */
+    if (bl + sizeof(size_t) > rb->len || len < bl) {
+        /* >>> Invalid block or invalid request >>> */
+        return 0;
+    }
+
+    /* Let the next block load while the payload is being copied */
+    ringbuffer_prefetch_block(rb, sizeof(size_t) + bl);
+
+    /* Read payload and discard the whole block */
+    ringbuffer_peek_unchecked(rb, sizeof(size_t), block, bl);
+    ringbuffer_discard_unchecked(rb, sizeof(size_t) + bl);
+
+    return bl;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_peek_block(ringbuffer_t* rb, uint8_t* block, size_t len) {
+
+    if (rb == 0 || block == 0) {
+        return 0;
+    }
+
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_PEEK_BLOCK, len, 0);
+
+    /* Read the block length with sanity checks */
+    int bl = ringbuffer_peek_block_length(rb);
+
+    if (bl <= 0) {
+        /* >>> Invalid block >>> */
+        return 0;
+    }
+
+    if (len < (size_t)bl) {
+        /* >>> Block is read only partially >>> */
+        bl = len;
+    }
+
+    /* Peek payload */
+    ringbuffer_peek_unchecked(rb, sizeof(size_t), block, bl);
+
+    return bl;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_peek_block_length(ringbuffer_t* rb) {
+
+    if (rb == 0) {
+        return 0;
+    }
+
+    /* Read the Block length */
+    size_t bl = 0;
+    if (ringbuffer_peek_length(rb, 0, &bl) != sizeof(size_t)) {
+        /* >>> Invalid block >>> */
+        return 0;
+    }
+
+    /* Sanity check: make sure the block is complete */
+    if (bl + sizeof(size_t) > rb->len) {
+        /* >>> Invalid block >>> */
+        return -1;
+    }
+
+    return bl;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_discard_block(ringbuffer_t* rb) {
+
+    if (rb == 0) {
+        return 0;
+    }
+
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_DISCARD_BLOCK, 0, 0);
+
+    /* Read the block length with sanity checks */
+    int bl = ringbuffer_peek_block_length(rb);
+
+    if (bl <= 0) {
+        /* >>> Invalid block >>> */
+        return 0;
+    }
+
+    /* The caller is likely to access the next block next */
+    ringbuffer_prefetch_block(rb, sizeof(size_t) + bl);
+
+    /* Discard block */
+    ringbuffer_discard_unchecked(rb, bl + sizeof(size_t));
+
+    return bl + sizeof(size_t);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_count_blocks(ringbuffer_t* rb) {
+
+    if (rb == 0) {
+        return 0;
+    }
+
+    /* The number of blocks */
+    size_t n = 0;
+
+    /* Length of a block */
+    size_t bl;
+
+    /* Traverse ringbuffer and count blocks */
+    size_t len = rb->len;
+    size_t offset = 0;
+    while (len > sizeof(size_t)) {
+        len -= sizeof(size_t);
+        if (ringbuffer_peek_length(rb, offset, &bl) == sizeof(size_t)
+                && bl <= len) {
+            /* >>> Found one more block */
+            ++n;
+            /* Start loading the next length field early (the payload
+             * is stepped over, so don't fetch it) */
+            ringbuffer_prefetch(rb,
+                    offset + sizeof(size_t) + bl, sizeof(size_t));
+            /* Step over this block */
+            len -= bl;
+            offset += sizeof(size_t) + bl;
+        } else {
+            /* something is wrong */
+            return 0;
+        }
+    }
+
+    return n;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_write_frame(ringbuffer_t* rb,
+        uint8_t* header, size_t hlen, uint8_t* data, size_t plen) {
+
+    /* Sanity check: make sure input pointer are ok */
+    if (rb == 0 || header == 0 || data == 0) {
+        /* >>> Invalid pointer(s) >>> */
+        return -1;
+    }
+
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_WRITE_FRAME, plen, hlen);
+
+    /* The total frame length including header */
+    size_t len = hlen + plen;
+
+    /* only write frame if there is enough space for
+     * the full frame (assuming len never exceeds size) */
+    if ((sizeof(size_t) + len) > (size_t)(rb->size - rb->len)) {
+        /* >>> Ringbuffer too small to write frame >>> */
+        return -1;
+    }
+
+    /* Write total frame length, header and data
+     * (cannot fail after the check above) */
+    ringbuffer_write_length(rb, len);
+    ringbuffer_write_unchecked(rb, header, hlen);
+    ringbuffer_write_unchecked(rb, data, plen);
+
+    /* Return the total number of bytes written to the ringbuffer */
+    return len + sizeof(size_t);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_peek_frame(ringbuffer_t* rb,
+        uint8_t* header, size_t hlen, uint8_t* payload, size_t max_plen) {
+
+    /* Sanity check: make sure input pointer are ok */
+    if (rb == 0 || header == 0 || payload == 0) {
+        /* >>> Invalid pointer(s) >>> */
+        return -1;
+    }
+
+    /* The length of the next frame in the ringbuffer */
+    size_t len = 0;
+
+    if (ringbuffer_peek_length(rb, 0, &len) != sizeof(size_t)) {
+        /* >>> Reading frame length failed >>> */
+        return -1;
+    }
+
+    /* Sanity check: make sure the whole frame fits into remaining data */
+    if (len + sizeof(size_t) > rb->len || len < hlen) {
+        /* >>> Frame seems longer than there is data in the ringbuffer
+         * or shorter than the header >>> */
+        return -1;
+    }
+
+    /* Make sure the user-provided buffer is sufficiently large */
+    if (len > (hlen + max_plen)) {
+        /* >>> User-provided buffer too small to hold frame data >>> */
+        return -1;
+    }
+
+    /* Let the next frame load while this one is being copied */
+    ringbuffer_prefetch_block(rb, sizeof(size_t) + len);
+
+    /* Peek frame header and data */
+    ringbuffer_peek_unchecked(rb, sizeof(size_t), header, hlen);
+    ringbuffer_peek_unchecked(rb, sizeof(size_t) + hlen, payload, len - hlen);
+
+    /* Return the frame data's length */
+    return len - hlen;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_read_frame(ringbuffer_t* rb,
+        uint8_t* header, size_t hlen, uint8_t* payload, size_t max_plen) {
+
+    /* Sanity check: make sure input pointer are ok */
+    if (rb == 0 || header == 0 || payload == 0) {
+        /* >>> Invalid pointer(s) >>> */
+        return -1;
+    }
+
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_READ_FRAME, max_plen, hlen);
+
+    /* Peek frame (includes further sanity checks) */
+    int plen = ringbuffer_peek_frame(rb, header, hlen, payload, max_plen);
+
+    /* Discard frame if peeked successfully */
+    if (plen >= 0) {
+        /* Discard frame length, frame header and data  */
+        ringbuffer_discard_unchecked(rb, sizeof(size_t) + hlen + plen);
+    }
+
+    /* Return the number of payload bytes read, or error indication */
+    return plen;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_write_nocheck(
+        ringbuffer_t* rb, const uint8_t* data, size_t len) {
+
+    assert(rb != 0 && data != 0);
+    assert(len <= (size_t)(rb->size - rb->len));
+
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_WRITE_ALL, len, 0);
+
+    ringbuffer_write_unchecked(rb, data, len);
+
+    return len;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_read_nocheck(ringbuffer_t* rb, uint8_t* data, size_t len) {
+
+    assert(rb != 0 && data != 0);
+    assert(len <= rb->len);
+
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_READ, len, 0);
+
+    ringbuffer_peek_unchecked(rb, 0, data, len);
+    ringbuffer_discard_unchecked(rb, len);
+
+    return len;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_peek_offset_nocheck(
+        ringbuffer_t* rb, size_t offset, uint8_t* data, size_t len) {
+
+    assert(rb != 0 && data != 0);
+    assert(offset + len <= rb->len);
+
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_PEEK, len, offset);
+
+    ringbuffer_peek_unchecked(rb, offset, data, len);
+
+    return len;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_discard_nocheck(ringbuffer_t* rb, size_t len) {
+
+    assert(rb != 0);
+    assert(len <= rb->len);
+
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_DISCARD, len, 0);
+
+    ringbuffer_discard_unchecked(rb, len);
+
+    return len;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_write_block_nocheck(
+        ringbuffer_t* rb, const uint8_t* block, size_t len) {
+
+    assert(rb != 0 && block != 0);
+    assert(len + sizeof(size_t) <= (size_t)(rb->size - rb->len));
+
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_WRITE_BLOCK, len, 0);
+
+    ringbuffer_write_length(rb, len);
+    ringbuffer_write_unchecked(rb, block, len);
+
+    return len + sizeof(size_t);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_read_block_nocheck(
+        ringbuffer_t* rb, uint8_t* block, size_t len) {
+
+    assert(rb != 0 && block != 0);
+
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_READ_BLOCK, len, 0);
+
+    size_t bl = 0;
+    ringbuffer_peek_length(rb, 0, &bl);
+
+    assert(bl + sizeof(size_t) <= rb->len && bl <= len);
+    (void)len;
+
+    ringbuffer_prefetch_block(rb, sizeof(size_t) + bl);
+
+    ringbuffer_peek_unchecked(rb, sizeof(size_t), block, bl);
+    ringbuffer_discard_unchecked(rb, sizeof(size_t) + bl);
+
+    return bl;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_write_frame_nocheck(ringbuffer_t* rb,
+        const uint8_t* header, size_t hlen, const uint8_t* data, size_t plen) {
+
+    assert(rb != 0 && header != 0 && data != 0);
+    assert(sizeof(size_t) + hlen + plen <= (size_t)(rb->size - rb->len));
+
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_WRITE_FRAME, plen, hlen);
+
+    ringbuffer_write_length(rb, hlen + plen);
+    ringbuffer_write_unchecked(rb, header, hlen);
+    ringbuffer_write_unchecked(rb, data, plen);
+
+    return sizeof(size_t) + hlen + plen;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_read_frame_nocheck(ringbuffer_t* rb,
+        uint8_t* header, size_t hlen, uint8_t* payload, size_t max_plen) {
+
+    assert(rb != 0 && header != 0 && payload != 0);
 
-        /* copy data until end of buffer */
-        memcpy(data, rb->buffer + rb->ir, len);
+    RINGBUFFER_TRACE_OP(rb, RINGBUFFER_OP_READ_FRAME, max_plen, hlen);
 
-    } else {
+    size_t len = 0;
+    ringbuffer_peek_length(rb, 0, &len);
 
-        /* copy data until end of buffer (assuming
-         * write index never exceeds size) */
-        memcpy(data, rb->buffer + rb->ir, linlen);
+    assert(len + sizeof(size_t) <= rb->len);
+    assert(hlen <= len && len <= hlen + max_plen);
+    (void)max_plen;
 
-        /* copy remaining data to beginning of buffer */
-        memcpy(data + linlen, rb->buffer, len - linlen);
+    ringbuffer_prefetch_block(rb, sizeof(size_t) + len);
 
-    }
+    ringbuffer_peek_unchecked(rb, sizeof(size_t), header, hlen);
+    ringbuffer_peek_unchecked(rb, sizeof(size_t) + hlen, payload, len - hlen);
+    ringbuffer_discard_unchecked(rb, sizeof(size_t) + len);
 
-    return len;
+    return len - hlen;
 }
 
 
 /*
  * ___________________________________________________________________________
  */
-int ringbuffer_peek_offset(
-        ringbuffer_t* rb, size_t offset, uint8_t* data, size_t len) {
+int ringbuffer_get_segments(ringbuffer_t* rb,
+        size_t offset, size_t len, ringbuffer_segments_t* seg) {
 
-    if (rb == 0 || data == 0) {
-        /* >>> Invalid pointer to ringbuffer or data buffer >>> */
+    if (rb == 0 || seg == 0) {
+        /* >>> Invalid pointer to ringbuffer or segment descriptor >>> */
         return -1;
     }
 
-    /* vLen is the "virtual" length of the ringbuffer's
-     *  content after considering data to disregard (offset) */
-    size_t vLen = rb->len;
-    if (offset < vLen) {
-        vLen -= offset;
-    } else {
-        vLen = 0;
+    if (offset > rb->len) {
+        /* >>> Offset beyond content: describe nothing >>> */
+        seg->data[0] = seg->data[1] = rb->buffer;
+        seg->len[0] = seg->len[1] = 0;
+        return -1;
     }
 
-    /* don't read more than there is data */
+    /* the "virtual" length of the ringbuffer's content
+     * after considering data to disregard (offset) */
+    size_t vLen = rb->len - offset;
+
+    /* don't describe more than there is data */
     if (len > vLen) {
         len = vLen;
     }
 
-    /* the "virtual" read index of the ringbuffer's
-     * after considering data to disregard (offset) */
+    /* the "virtual" read index after considering the offset */
     size_t vir = rb->ir + offset;
     if (vir >= rb->size) {
         vir -= rb->size;
@@ -346,20 +1173,18 @@ int ringbuffer_peek_offset(
 
     /* assuming read index never exceeds size */
     size_t linlen = (size_t)(rb->size - vir);
-    if (len <= linlen) {
-
-        /* copy data until end of buffer */
-        memcpy(data, rb->buffer + vir, len);
 
+    seg->data[0] = rb->buffer + vir;
+    if (len <= linlen) {
+        /* >>> Range is linear >>> */
+        seg->len[0] = len;
+        seg->data[1] = rb->buffer;
+        seg->len[1] = 0;
     } else {
-
-        /* copy data until end of buffer (assuming
-         * write index never exceeds size) */
-        memcpy(data, rb->buffer + vir, linlen);
-
-        /* copy remaining data to beginning of buffer */
-        memcpy(data + linlen, rb->buffer, len - linlen);
-
+        /* >>> Range wraps around the end of the buffer >>> */
+        seg->len[0] = linlen;
+        seg->data[1] = rb->buffer;
+        seg->len[1] = len - linlen;
     }
 
     return len;
@@ -369,383 +1194,355 @@ int ringbuffer_peek_offset(
 /*
  * ___________________________________________________________________________
  */
-int ringbuffer_find(
-        ringbuffer_t* rb, size_t offset, uint8_t* data, size_t len) {
-
-    if (rb == 0 || data == 0) {
-        /* >>> Invalid pointer to ringbuffer or data buffer >>> */
-        return -1;
-    }
+static int ringbuffer_find_byte_range(
+        ringbuffer_t* rb, size_t offset, size_t len, uint8_t byte) {
 
-    if (len == 0 || len > rb->len) {
-        /* >>> Invalid search pattern >>> */
-        return -1;
-    }
+    ringbuffer_segments_t seg;
+    ringbuffer_get_segments(rb, offset, len, &seg);
 
-    /* Search index */
-    size_t index = rb->ir + offset;
+    for (int i = 0; i < 2; i++) {
 
-    while (offset <= (rb->len - len)) {
-
-        /* Search pattern index */
-        size_t i = index;
-        size_t j = 0;
-        while (j < len) {            
-            if (rb->buffer[i] != data[j]) {
-                /* >>> Mismatch >>> */
-                break;
-            }
-            /* Advance sub-indices */
-            j++;
-            if (++i >= rb->size) {
-                /* Wrap sub-index */
-                i = 0;
-            }
-        }
+        /* Search each linear region with memchr */
+        const uint8_t* p = memchr(seg.data[i], byte, seg.len[i]);
 
-        if (j == len) {
-            /* >>> Found at offset! >>> */
-            return offset;
+        if (p != 0) {
+            /* >>> Found: translate pointer back into an offset >>> */
+            return offset + (size_t)(p - seg.data[i]);
         }
 
-        /* Advance offset / search index */
-        offset++;
-        if (++index >= rb->size) {
-            /* Wrap search index */
-            index = 0;
-        }
+        offset += seg.len[i];
     }
 
-    /* >>> Search pattern not found >>> */
     return -1;
 }
 
 
 /*
+ * Portable memrchr(): returns a pointer to the last occurrence of <byte>
+ * within <len> bytes at <p>, or 0 if there is none.
  * ___________________________________________________________________________
  */
-int ringbuffer_discard(ringbuffer_t* rb, size_t len) {
-
-    if (rb == 0) {
-        /* >>> Invalid pointer to ringbuffer or data buffer >>> */
-        return -1;
-    }
-
-    /* don't discard more than there is data */
-    if (len > rb->len) {
-        len = rb->len;
+static const uint8_t* ringbuffer_memrchr(
+        const uint8_t* p, uint8_t byte, size_t len) {
+
+#if defined(__SSE2__) && defined(__GNUC__)
+    /* Compare 16 bytes at a time, walking backwards from the end */
+    const __m128i needle = _mm_set1_epi8((char)byte);
+    while (len >= 16) {
+        len -= 16;
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(
+                _mm_loadu_si128((const __m128i*)(p + len)), needle));
+        if (mask != 0) {
+            return p + len + (31 - __builtin_clz(mask));
+        }
     }
+#endif
 
-    rb->len -= len;
-
-    /* assuming read index never exceeds size */
-    size_t linlen = (size_t)(rb->size - rb->ir);
-
-    if (len < linlen) {
-        /* advance read index */
-        rb->ir += len;
-    } else if (len == linlen) {
-        /* here: rb->ir == rb->size, so wrap read index */
-        rb->ir = 0;
-    } else {
-        /* read index implicitly wrapped */
-        rb->ir = len - linlen;
+    while (len > 0) {
+        if (p[--len] == byte) {
+            return p + len;
+        }
     }
 
-    return len;
+    return 0;
 }
 
 
 /*
  * ___________________________________________________________________________
  */
-int ringbuffer_write_block(ringbuffer_t* rb, const uint8_t* block, size_t len) {
-
-    /* Sanity check: make sure input pointers are ok */
-    if (rb == 0 || block == 0) {
-        /* >>> Invalid pointer to ringbuffer or block data to write >>> */
-        return 0;
-    }
-
-    /* only write block if there is enough space for
-     * the full block (assuming len never exceeds size) */
-    size_t space = (size_t)(rb->size - rb->len);
+int ringbuffer_find_byte(ringbuffer_t* rb, size_t offset, uint8_t byte) {
 
-    if ((len + sizeof(size_t)) > space) {
-        /* >>> No enough space to write block >>> */
-        return -1;
-    }
-
-    /* Write block length */
-    if (ringbuffer_write_all(rb, (uint8_t*)&len, sizeof(size_t)) < 0) {
-        /* >>> Writing block length failed >>> */
+    if (rb == 0 || offset >= rb->len) {
+        /* >>> Invalid pointer to ringbuffer or nothing to search >>> */
         return -1;
     }
 
-    /* Write block data */
-    if (ringbuffer_write_all(rb, block, len) < 0) {
-        /* >>> Writing block data failed >>> */
-        /* We are in an inconsistent state now because writing the
-         * block length apparently succeeded, while writing the
-         * actual block data failed => return -2 instead of -1 here */
-        return -2;
-    }
-
-    /* Return the total number of bytes written to the ringbuffer */
-    return len + sizeof(size_t);
+    return ringbuffer_find_byte_range(rb, offset, rb->len - offset, byte);
 }
 
 
 /*
  * ___________________________________________________________________________
  */
-int ringbuffer_read_block(ringbuffer_t* rb, uint8_t* block, size_t len) {
+int ringbuffer_count_byte(
+        ringbuffer_t* rb, size_t offset, size_t len, uint8_t byte) {
 
-    if (rb == 0 || block == 0) {
-        return 0;
+    if (rb == 0) {
+        return -1;
     }
 
-    /* Read the Block length */
-    size_t bl = 0;
-    if (ringbuffer_peek(rb, (uint8_t*)&bl, sizeof(size_t)) != sizeof(size_t)) {
-        /* >>> Invalid block >>> */
-        return 0;
-    }
+    ringbuffer_segments_t seg;
+    ringbuffer_get_segments(rb, offset, len, &seg);
 
-    /* Sanity check: make sure that ...
-     *  -> the apparent payload is not longer than there is data
-     *  -> the user-provided buffer is sufficiently large to hold the payload
-     */
-    if (bl + sizeof(size_t) > rb->len || len < bl) {
-        /* >>> Invalid block or invalid request >>> */
-        return 0;
+    size_t n = 0;
+
+    for (int i = 0; i < 2; i++) {
+
+        /* Hop from occurrence to occurrence using memchr */
+        const uint8_t* p = seg.data[i];
+        const uint8_t* end = seg.data[i] + seg.len[i];
+
+        while (p < end && (p = memchr(p, byte, (size_t)(end - p))) != 0) {
+            n++;
+            p++;
+        }
     }
 
-    /* Discard header (we already read it) */
-    ringbuffer_discard(rb, sizeof(size_t));
-    
-    /* Read payload */
-    return ringbuffer_read(rb, block, bl);
+    return n;
 }
 
 
 /*
  * ___________________________________________________________________________
  */
-int ringbuffer_peek_block(ringbuffer_t* rb, uint8_t* block, size_t len) {
+int ringbuffer_index_byte(ringbuffer_t* rb, size_t offset, size_t len,
+        uint8_t byte, size_t* offsets, size_t max) {
 
-    if (block == 0) {
-        return 0;
+    if (rb == 0 || (offsets == 0 && max > 0)) {
+        /* >>> Invalid pointer to ringbuffer or offset array >>> */
+        return -1;
     }
 
-    /* Read the block length with sanity checks */
-    size_t bl = ringbuffer_peek_block_length(rb);
+    ringbuffer_segments_t seg;
+    ringbuffer_get_segments(rb, offset, len, &seg);
 
-    if (bl == 0) {
-        /* >>> Invalid block >>> */
-        return 0;
-    }
+    size_t n = 0;
 
-    if (len < bl) {
-        /* >>> Block is read only partially >>> */
-        bl = len;
+    for (int i = 0; i < 2 && n < max; i++) {
+
+        const uint8_t* p = seg.data[i];
+        size_t j = 0;
+
+#if defined(__SSE2__) && defined(__GNUC__)
+        /* Compare 16 bytes at a time and walk the set bits of the mask */
+        const __m128i needle = _mm_set1_epi8((char)byte);
+        for (; j + 16 <= seg.len[i] && n < max; j += 16) {
+            unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(
+                    _mm_loadu_si128((const __m128i*)(p + j)), needle));
+            while (mask != 0 && n < max) {
+                offsets[n++] = offset + j + (size_t)__builtin_ctz(mask);
+                mask &= mask - 1;
+            }
+        }
+#endif
+
+        /* Hop through the rest using memchr */
+        while (j < seg.len[i] && n < max) {
+            const uint8_t* q = memchr(p + j, byte, seg.len[i] - j);
+            if (q == 0) {
+                break;
+            }
+            j = (size_t)(q - p);
+            offsets[n++] = offset + j++;
+        }
+
+        offset += seg.len[i];
     }
 
-    /* Peek payload */
-    return ringbuffer_peek_offset(rb, sizeof(size_t), block, bl);
+    return n;
 }
 
 
 /*
  * ___________________________________________________________________________
  */
-int ringbuffer_peek_block_length(ringbuffer_t* rb) {
-
-    if (rb == 0) {
-        return 0;
-    }
-
-    /* Read the Block length */
-    size_t bl = 0;
-    if (ringbuffer_peek(rb, (uint8_t*)&bl, sizeof(size_t)) != sizeof(size_t)) {
-        /* >>> Invalid block >>> */
-        return 0;
-    }
+int ringbuffer_byteset_init(
+        ringbuffer_byteset_t* set, const uint8_t* bytes, size_t len) {
 
-    /* Sanity check: make sure the block is complete */
-    if (bl + sizeof(size_t) > rb->len) {
-        /* >>> Invalid block >>> */
+    if (set == 0 || (bytes == 0 && len > 0)) {
+        /* >>> Invalid pointer to byte set or byte values >>> */
         return -1;
     }
 
-    return bl;
-}
+    memset(set, 0, sizeof(*set));
 
+    for (size_t i = 0; i < len; i++) {
 
-/*
- * ___________________________________________________________________________
- */
-int ringbuffer_discard_block(ringbuffer_t* rb) {
-
-    /* Read the block length with sanity checks */
-    size_t bl = ringbuffer_peek_block_length(rb);
+        uint8_t b = bytes[i];
+        set->map[b >> 3] |= (uint8_t)(1 << (b & 7));
 
-    if (bl == 0) {
-        /* >>> Invalid block >>> */
-        return 0;
+        if (b < 0x80) {
+            set->lo[b & 0x0F] |= (uint8_t)(1 << (b >> 4));
+        } else {
+            set->hi[b & 0x0F] |= (uint8_t)(1 << ((b >> 4) - 8));
+        }
     }
 
-    /* Discard block */
-    return ringbuffer_discard(rb, bl + sizeof(size_t));
+    return 0;
 }
 
 
 /*
  * ___________________________________________________________________________
  */
-int ringbuffer_count_blocks(ringbuffer_t* rb) {
+int ringbuffer_find_any(
+        ringbuffer_t* rb, size_t offset, const ringbuffer_byteset_t* set) {
 
-    if (rb == 0) {
-        return 0;
+    if (rb == 0 || set == 0) {
+        /* >>> Invalid pointer to ringbuffer or byte set >>> */
+        return -1;
     }
 
-    /* The number of blocks */
-    size_t n = 0;
+    ringbuffer_segments_t seg;
+    ringbuffer_get_segments(rb, offset, rb->len, &seg);
 
-    /* Length of a block */
-    size_t bl;
+#if defined(__SSSE3__) && defined(__GNUC__)
+    const __m128i tlo = _mm_loadu_si128((const __m128i*)set->lo);
+    const __m128i thi = _mm_loadu_si128((const __m128i*)set->hi);
+    const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)128,
+            1, 2, 4, 8, 16, 32, 64, (char)128);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+#endif
 
-    /* Traverse ringbuffer and count blocks */
-    size_t len = rb->len;
-    size_t offset = 0;
-    while (len > sizeof(size_t)) {
-        len -= sizeof(size_t);
-        if (ringbuffer_peek_offset(rb, offset, (uint8_t*)&bl, sizeof(size_t))
-                == sizeof(size_t) && bl <= len) {
-            /* >>> Found one more block */
-            ++n;
-            /* Step over this block */
-            len -= bl;
-            offset += sizeof(size_t) + bl;
-        } else {
-            /* something is wrong */
-            return 0;
+    for (int i = 0; i < 2; i++) {
+
+        const uint8_t* p = seg.data[i];
+        size_t j = 0;
+
+#if defined(__SSSE3__) && defined(__GNUC__)
+        /* Classify 16 bytes at a time: look up the low nibble in both
+         * nibble tables, pick the table by the high nibble's top bit, and
+         * test the bit selected by the high nibble's lower three bits */
+        for (; j + 16 <= seg.len[i]; j += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(p + j));
+            __m128i lo = _mm_and_si128(v, nibble);
+            __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+            __m128i upper = _mm_cmpgt_epi8(hi, _mm_set1_epi8(7));
+            __m128i row = _mm_or_si128(
+                    _mm_andnot_si128(upper, _mm_shuffle_epi8(tlo, lo)),
+                    _mm_and_si128(upper, _mm_shuffle_epi8(thi, lo)));
+            __m128i hit = _mm_and_si128(row, _mm_shuffle_epi8(bits, hi));
+            unsigned mask = ~(unsigned)_mm_movemask_epi8(
+                    _mm_cmpeq_epi8(hit, _mm_setzero_si128())) & 0xFFFF;
+            if (mask != 0) {
+                /* >>> Found >>> */
+                return offset + j + (size_t)__builtin_ctz(mask);
+            }
+        }
+#endif
+
+        /* Look up the remaining bytes in the membership bitmap */
+        for (; j < seg.len[i]; j++) {
+            if (set->map[p[j] >> 3] & (1 << (p[j] & 7))) {
+                /* >>> Found >>> */
+                return offset + j;
+            }
         }
+
+        offset += seg.len[i];
     }
 
-    return n;
+    return -1;
 }
 
 
 /*
  * ___________________________________________________________________________
  */
-int ringbuffer_write_frame(ringbuffer_t* rb,
-        uint8_t* header, size_t hlen, uint8_t* data, size_t plen) {
+int ringbuffer_rfind(
+        ringbuffer_t* rb, size_t offset, const uint8_t* data, size_t len) {
 
-    /* Sanity check: make sure input pointer are ok */
-    if (rb == 0 || header == 0 || data == 0) {
-        /* >>> Invalid pointer(s) >>> */
+    if (rb == 0 || data == 0) {
+        /* >>> Invalid pointer to ringbuffer or data buffer >>> */
         return -1;
     }
 
-    /* The total frame length including header */
-    size_t len = hlen + plen;
-
-    /* only write frame if there is enough space for
-     * the full frame (assuming len never exceeds size) */
-    if ((sizeof(size_t) + len) > (size_t)(rb->size - rb->len)) {
-        /* >>> Ringbuffer too small to write frame >>> */
+    if (len == 0 || len > rb->len || offset > rb->len - len) {
+        /* >>> Invalid search pattern or nothing to search >>> */
         return -1;
     }
 
-    /* prepend and write total frame length */
-    if (ringbuffer_write_all(rb, (uint8_t*)&len, sizeof(size_t)) < 0) {
-        /* >>> Writing total length failed >>> */
-        return -1;
-    }
+    ringbuffer_segments_t seg;
+    ringbuffer_get_segments(rb, offset, rb->len - offset, &seg);
 
-    /* Write header */
-    if (ringbuffer_write_all(rb, header, hlen) < 0) {
-        /* >>> Writing header failed >>> */
-        /* We are in an inconsistent state now because writing the
-         * total length apparently succeeded, while writing the
-         * header failed => return -2 instead of -1 here */
-        return -2;
-    }
+    /* The number of offsets a match may start at */
+    size_t n = rb->len - len - offset + 1;
+
+    for (int i = 1; i >= 0; i--) {
+
+        /* Candidates starting within this linear region */
+        size_t base = (i == 0) ? 0 : seg.len[0];
+        size_t m = (n > base) ? n - base : 0;
+        if (m > seg.len[i]) {
+            m = seg.len[i];
+        }
 
-    /* Write data */
-    if (ringbuffer_write_all(rb, data, plen) < 0) {
-        /* >>> Writing data failed >>> */
-        /* We are in an inconsistent state now because writing the
-         * header apparently succeeded, while writing the
-         * data failed => return -2 instead of -1 here */
-        return -2;
+        /* Hop back from candidate to candidate by the first byte */
+        const uint8_t* p;
+        while (m > 0
+                && (p = ringbuffer_memrchr(seg.data[i], data[0], m)) != 0) {
+
+            size_t j = (size_t)(p - seg.data[i]);
+            size_t tail = seg.len[i] - j;
+
+            if (tail >= len) {
+                /* Window is linear: compare in place */
+                if (memcmp(p, data, len) == 0) {
+                    /* >>> Found at offset! >>> */
+                    return offset + base + j;
+                }
+            } else if (memcmp(p, data, tail) == 0
+                    && memcmp(seg.data[1], data + tail, len - tail) == 0) {
+                /* >>> Found at offset (window wraps around)! >>> */
+                return offset + base + j;
+            }
+
+            /* Continue in front of candidate */
+            m = j;
+        }
     }
 
-    /* Return the total number of bytes written to the ringbuffer */
-    return len + sizeof(size_t);
+    /* >>> Search pattern not found >>> */
+    return -1;
 }
 
 
 /*
  * ___________________________________________________________________________
  */
-int ringbuffer_peek_frame(ringbuffer_t* rb,
-        uint8_t* header, size_t hlen, uint8_t* payload, size_t max_plen) {
-
-    /* Sanity check: make sure input pointer are ok */
-    if (rb == 0 || header == 0 || payload == 0) {
-        /* >>> Invalid pointer(s) >>> */
-        return -1;
-    }
-
-    /* The length of the next frame in the ringbuffer */
-    size_t len = 0;
-
-    if (ringbuffer_peek(rb, (uint8_t*)&len, sizeof(size_t))
-            != sizeof(size_t)) {
-        /* >>> Reading frame length failed >>> */
-        return -1;
-    }
+int ringbuffer_equal(
+        ringbuffer_t* rb, size_t offset, const uint8_t* data, size_t len) {
 
-    /* Sanity check: make sure the whole frame fits into remaining data */
-    if (len + sizeof(size_t) > rb->len) {
-        /* >>> Frame seems longer than there is data in the ringbuffer >>> */
+    if (rb == 0 || data == 0) {
+        /* >>> Invalid pointer to ringbuffer or data buffer >>> */
         return -1;
     }
 
-    /* Make sure the user-provided buffer is sufficiently large */
-    if (len > (hlen + max_plen)) {
-        /* >>> User-provided buffer too small to hold frame data >>> */
-        return -1;
+    ringbuffer_segments_t seg;
+    int n = ringbuffer_get_segments(rb, offset, len, &seg);
+    if (n < 0 || (size_t)n != len) {
+        /* >>> Not enough content >>> */
+        return 0;
     }
 
-    /* Peek frame header */
-    ringbuffer_peek_offset(rb, sizeof(size_t), header, hlen);
-
-    /* Peek frame data and return its length */
-    return ringbuffer_peek_offset(rb,
-            sizeof(size_t) + hlen, payload, len - hlen);
+    /* Compare each linear region with memcmp */
+    return memcmp(seg.data[0], data, seg.len[0]) == 0
+            && memcmp(seg.data[1], data + seg.len[0], seg.len[1]) == 0;
 }
 
 
 /*
  * ___________________________________________________________________________
  */
-int ringbuffer_read_frame(ringbuffer_t* rb,
-        uint8_t* header, size_t hlen, uint8_t* payload, size_t max_plen) {
+int ringbuffer_copy(ringbuffer_t* dst,
+        ringbuffer_t* src, size_t offset, size_t len) {
 
-    /* Peek frame (includes sanity checks) */
-    size_t plen = ringbuffer_peek_frame(rb, header, hlen, payload, max_plen);
+    if (dst == 0 || src == 0) {
+        /* >>> Invalid pointer to ringbuffer(s) >>> */
+        return -1;
+    }
 
-    /* Discard frame if peeked successfully */
-    if (plen >= 0) {
-        /* Discard frame length, frame header and data  */
-        ringbuffer_discard(rb, sizeof(size_t) + hlen + plen);
+    ringbuffer_segments_t seg;
+    int n = ringbuffer_get_segments(src, offset, len, &seg);
+    if (n < 0 || (size_t)n != len || len > (size_t)(dst->size - dst->len)) {
+        /* >>> Not enough content in source or space in destination >>> */
+        return -1;
     }
 
-    /* Return the number of payload bytes read, or error indication */
-    return plen;
-}
+    /* Copy each linear region (cannot fail after the check above) */
+    ringbuffer_write_all(dst, seg.data[0], seg.len[0]);
+    ringbuffer_write_all(dst, seg.data[1], seg.len[1]);
 
+    return len;
+}
@@ -30,6 +30,46 @@
 #include <stddef.h>
 
 
+/*
+ * Default minimum length of a write from which on data is copied into a
+ * ringbuffer bypassing the cache (0 = never), set by ringbuffer_init() and
+ * changeable per ringbuffer (see ringbuffer_set_stream_threshold()).
+ * The non-temporal copy is selected at build time: it is only compiled in if
+ * SSE2 is enabled (__SSE2__), otherwise all writes use memcpy().
+ */
+#ifndef RINGBUFFER_STREAM_THRESHOLD
+#define RINGBUFFER_STREAM_THRESHOLD 0
+#endif
+
+/*
+ * Number of payload bytes of the next block/frame to prefetch (in addition
+ * to its length field) while reading or stepping over a block/frame
+ * (0 = prefetch the length field only, -1 = disable prefetching)
+ */
+#ifndef RINGBUFFER_PREFETCH_DISTANCE
+#define RINGBUFFER_PREFETCH_DISTANCE 64
+#endif
+
+
+/*
+ * Operations reported to the trace hook (only if compiled with
+ * RINGBUFFER_TRACE defined; see ringbuffer_set_trace_hook)
+ */
+#define RINGBUFFER_OP_WRITE         1
+#define RINGBUFFER_OP_WRITE_ALL     2
+#define RINGBUFFER_OP_READ          3
+#define RINGBUFFER_OP_PEEK          4
+#define RINGBUFFER_OP_DISCARD       5
+#define RINGBUFFER_OP_FIND          6
+#define RINGBUFFER_OP_WRITE_BLOCK   7
+#define RINGBUFFER_OP_READ_BLOCK    8
+#define RINGBUFFER_OP_WRITE_FRAME   9
+#define RINGBUFFER_OP_READ_FRAME    10
+#define RINGBUFFER_OP_DISCARD_BLOCK 11
+#define RINGBUFFER_OP_CLEAR         12
+#define RINGBUFFER_OP_PEEK_BLOCK    13
+
+
 /*
  * TODO: Add description
  */
@@ -55,9 +95,57 @@ typedef struct {
     /* reading index */
     size_t ir;
 
+    /* number of bytes written since initialization (wraps around; lets
+     * observers such as replicas detect overruns) */
+    size_t written;
+
+    /* minimum length of a write to copy bypassing the cache (0 = never) */
+    size_t stream_threshold;
+
 } ringbuffer_t;
 
 
+/*
+ * Up to two linear memory regions describing a range of ringbuffer content
+ * (the second one is only used if the range wraps around the buffer's end)
+ */
+typedef struct {
+
+    /* pointers to the first and second region */
+    uint8_t* data[2];
+
+    /* lengths of the first and second region */
+    size_t len[2];
+
+} ringbuffer_segments_t;
+
+
+/*
+ * A set of byte values to search for with ringbuffer_find_any()
+ */
+typedef struct {
+
+    /* membership bitmap (bit b % 8 of map[b / 8] is set for member b) */
+    uint8_t map[32];
+
+    /* nibble tables: bit h of lo[l] (hi[l]) is set if byte (h << 4) | l
+     * (((h + 8) << 4) | l) is a member */
+    uint8_t lo[16];
+    uint8_t hi[16];
+
+} ringbuffer_byteset_t;
+
+
+/*
+ * Function called for every traced operation <op> on ringbuffer <rb>. <len>
+ * is the requested length (the user buffer's length for block/frame reads,
+ * the payload length for frames), <aux> the offset for peek/find and the
+ * header length for frames (0 otherwise).
+ */
+typedef void (*ringbuffer_trace_hook_t)(void* ctx,
+        ringbuffer_t* rb, int op, size_t len, size_t aux);
+
+
 /* ========================================================================= */
 
 /*
@@ -66,6 +154,31 @@ typedef struct {
 int ringbuffer_init(ringbuffer_t* rb, uint8_t* mem, size_t memlen);
 
 
+/*
+ * Sets the minimum length of a write from which on data is copied into
+ * ringbuffer <rb> using non-temporal stores, i.e. without evicting cache
+ * lines (0 disables this). Intended for rings whose consumer won't read large
+ * writes soon; other rings keep their cache-friendly writes, which is why the
+ * threshold is kept per ringbuffer rather than process-wide. It is compared
+ * against the whole length of a write (not the parts before and after the
+ * wrap point) and may be changed at any time (it is accessed atomically).
+ * Returns -1 if not supported by the build (see RINGBUFFER_STREAM_THRESHOLD).
+ */
+int ringbuffer_set_stream_threshold(ringbuffer_t* rb, size_t threshold);
+
+
+/*
+ * Installs <hook> (with context <ctx>) to be called for every operation
+ * on any ringbuffer (0 removes the hook). Returns -1 if tracing has not
+ * been compiled in (RINGBUFFER_TRACE), so there is no cost otherwise.
+ * The hook may be installed or removed while other threads operate on
+ * ringbuffers (it is accessed atomically), but an operation already under
+ * way may still call the previous hook, possibly with the new context: keep
+ * a hook's context valid until such operations have completed.
+ */
+int ringbuffer_set_trace_hook(ringbuffer_trace_hook_t hook, void* ctx);
+
+
 /*
  * TODO: Add description
  */
@@ -191,5 +304,121 @@ int ringbuffer_peek_frame(ringbuffer_t* rb,
 int ringbuffer_read_frame(ringbuffer_t* rb,
         uint8_t* header, size_t hlen, uint8_t* frame, size_t max_plen);
 
+
+/* ========================================================================= */
+/* Unchecked access                                                          */
+/* ========================================================================= */
+
+/*
+ * The following functions behave like their checked counterparts, but
+ * leave validating arguments to the caller: pointers must be valid, writes
+ * must fit into the ringbuffer and reads must not exceed its content (or,
+ * for blocks/frames, the next block/frame must be complete and fit into the
+ * user-provided buffer). Preconditions are only enforced by assertions, so
+ * violating them in builds with NDEBUG is undefined behaviour. Nothing is
+ * truncated, so the return value is always the number of bytes requested.
+ */
+
+int ringbuffer_write_nocheck(
+        ringbuffer_t* rb, const uint8_t* data, size_t len);
+
+int ringbuffer_read_nocheck(ringbuffer_t* rb, uint8_t* data, size_t len);
+
+int ringbuffer_peek_offset_nocheck(
+        ringbuffer_t* rb, size_t offset, uint8_t* data, size_t len);
+
+int ringbuffer_discard_nocheck(ringbuffer_t* rb, size_t len);
+
+int ringbuffer_write_block_nocheck(
+        ringbuffer_t* rb, const uint8_t* block, size_t len);
+
+int ringbuffer_read_block_nocheck(
+        ringbuffer_t* rb, uint8_t* block, size_t len);
+
+int ringbuffer_write_frame_nocheck(ringbuffer_t* rb,
+        const uint8_t* header, size_t hlen, const uint8_t* data, size_t plen);
+
+int ringbuffer_read_frame_nocheck(ringbuffer_t* rb,
+        uint8_t* header, size_t hlen, uint8_t* payload, size_t max_plen);
+
+
+/* ========================================================================= */
+/* Segment access                                                            */
+/* ========================================================================= */
+
+
+/*
+ * Describes up to <len> bytes of content starting at <offset> (relative to
+ * the read index) as (at most) two linear regions of the buffer, allowing
+ * to access content in place. Returns the total length described, or -1
+ * (with both regions empty) if <offset> lies beyond the content.
+ */
+int ringbuffer_get_segments(ringbuffer_t* rb,
+        size_t offset, size_t len, ringbuffer_segments_t* seg);
+
+
+/*
+ * Returns the offset of the first occurrence of <byte> at or after <offset>,
+ * or -1 if there is none.
+ */
+int ringbuffer_find_byte(ringbuffer_t* rb, size_t offset, uint8_t byte);
+
+
+/*
+ * Returns the number of occurrences of <byte> within <len> bytes of content
+ * starting at <offset>.
+ */
+int ringbuffer_count_byte(
+        ringbuffer_t* rb, size_t offset, size_t len, uint8_t byte);
+
+
+/*
+ * Stores the offsets of (at most <max>) occurrences of <byte> within <len>
+ * bytes of content starting at <offset> in <offsets>, in ascending order,
+ * using a single pass over the content. Returns the number of offsets stored.
+ */
+int ringbuffer_index_byte(ringbuffer_t* rb, size_t offset, size_t len,
+        uint8_t byte, size_t* offsets, size_t max);
+
+
+/*
+ * Sets up byte set <set> to contain the <len> byte values in <bytes>.
+ */
+int ringbuffer_byteset_init(
+        ringbuffer_byteset_t* set, const uint8_t* bytes, size_t len);
+
+
+/*
+ * Returns the offset of the first byte at or after <offset> that is a member
+ * of <set>, or -1 if there is none.
+ */
+int ringbuffer_find_any(
+        ringbuffer_t* rb, size_t offset, const ringbuffer_byteset_t* set);
+
+
+/*
+ * Returns the offset of the last occurrence of <data> (<len> bytes) that
+ * starts at or after <offset>, or -1 if there is none. The search walks
+ * backwards from the write index.
+ */
+int ringbuffer_rfind(
+        ringbuffer_t* rb, size_t offset, const uint8_t* data, size_t len);
+
+
+/*
+ * Returns 1 if the <len> bytes of content starting at <offset> equal <data>,
+ * 0 if they differ (or there is less content), or -1 on invalid input.
+ */
+int ringbuffer_equal(
+        ringbuffer_t* rb, size_t offset, const uint8_t* data, size_t len);
+
+
+/*
+ * Copies <len> bytes of content starting at <offset> from ringbuffer <src>
+ * to ringbuffer <dst> (all or nothing). Returns the number of bytes copied.
+ */
+int ringbuffer_copy(ringbuffer_t* dst,
+        ringbuffer_t* src, size_t offset, size_t len);
+
 #endif
 
@@ -0,0 +1,286 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "ringbuffer_cmdq.h"
+#include <string.h>
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static size_t ringbuffer_cmdq_align(size_t len) {
+
+    return (len + RINGBUFFER_CMDQ_ALIGN - 1)
+            & ~(size_t)(RINGBUFFER_CMDQ_ALIGN - 1);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void ringbuffer_cmdq_put_header(ringbuffer_t* rb,
+        size_t total, const ringbuffer_cmdq_ops_t* ops) {
+
+    /* Entries are regular blocks: the length excludes the length field */
+    size_t bl = total - sizeof(size_t);
+
+    memcpy(rb->buffer + rb->iw, &bl, sizeof(size_t));
+    memcpy(rb->buffer + rb->iw + sizeof(size_t),
+            &ops, sizeof(const ringbuffer_cmdq_ops_t*));
+
+    /* Advance write index */
+    rb->iw += total;
+    if (rb->iw == rb->size) {
+        /* Wrap write index */
+        rb->iw = 0;
+    }
+    rb->len += total;
+    rb->written += total;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static size_t ringbuffer_cmdq_get_header(
+        ringbuffer_t* rb, const ringbuffer_cmdq_ops_t** ops) {
+
+    /* Skip filler entries (no operations) up to the end of the buffer */
+    while (rb->len > 0) {
+
+        size_t bl;
+        memcpy(&bl, rb->buffer + rb->ir, sizeof(size_t));
+        memcpy(ops, rb->buffer + rb->ir + sizeof(size_t),
+                sizeof(const ringbuffer_cmdq_ops_t*));
+
+        if (*ops != 0) {
+            /* Return the size of the object's storage */
+            return bl + sizeof(size_t) - RINGBUFFER_CMDQ_ALIGN;
+        }
+
+        ringbuffer_discard(rb, bl + sizeof(size_t));
+    }
+
+    /* >>> Queue is empty >>> */
+    return 0;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_cmdq_init(ringbuffer_t* rb, uint8_t* mem, size_t memlen) {
+
+    /* An entry header has to fit into the alignment unit such that a filler
+     * entry can always be placed in front of the end of the buffer */
+    if (sizeof(size_t) + sizeof(void*) > RINGBUFFER_CMDQ_ALIGN) {
+        return -1;
+    }
+
+    /* Only use a multiple of the alignment unit */
+    return ringbuffer_init(rb, mem,
+            memlen & ~(size_t)(RINGBUFFER_CMDQ_ALIGN - 1));
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+void* ringbuffer_cmdq_emplace(ringbuffer_t* rb,
+        const ringbuffer_cmdq_ops_t* ops, size_t size) {
+
+    if (rb == 0 || ops == 0) {
+        /* >>> Invalid pointer to ringbuffer or operations >>> */
+        return 0;
+    }
+
+    /* The entry's total length including its header */
+    size_t total = RINGBUFFER_CMDQ_ALIGN + ringbuffer_cmdq_align(size);
+
+    size_t space = (size_t)(rb->size - rb->len);
+    size_t linlen = (size_t)(rb->size - rb->iw);
+
+    if (total > linlen) {
+        /* >>> Entry would wrap: fill up to the end of the buffer >>> */
+
+        if (linlen + total > space) {
+            /* >>> Not enough space for filler and entry >>> */
+            return 0;
+        }
+
+        ringbuffer_cmdq_put_header(rb, linlen, 0);
+
+    } else if (total > space) {
+        /* >>> Not enough space for entry >>> */
+        return 0;
+    }
+
+    uint8_t* obj = rb->buffer + rb->iw + RINGBUFFER_CMDQ_ALIGN;
+
+    ringbuffer_cmdq_put_header(rb, total, ops);
+
+    return obj;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+void* ringbuffer_cmdq_front(
+        ringbuffer_t* rb, const ringbuffer_cmdq_ops_t** ops) {
+
+    if (rb == 0) {
+        return 0;
+    }
+
+    const ringbuffer_cmdq_ops_t* o;
+    ringbuffer_cmdq_get_header(rb, &o);
+
+    if (rb->len == 0) {
+        /* >>> Queue is empty >>> */
+        return 0;
+    }
+
+    if (ops != 0) {
+        *ops = o;
+    }
+
+    return rb->buffer + rb->ir + RINGBUFFER_CMDQ_ALIGN;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_cmdq_invoke(ringbuffer_t* rb) {
+
+    const ringbuffer_cmdq_ops_t* ops;
+    void* obj = ringbuffer_cmdq_front(rb, &ops);
+
+    if (obj == 0) {
+        return 0;
+    }
+
+    if (ops->invoke != 0) {
+        ops->invoke(obj);
+    }
+
+    return ringbuffer_cmdq_discard(rb);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_cmdq_run(ringbuffer_t* rb) {
+
+    int n = 0;
+
+    while (ringbuffer_cmdq_invoke(rb) > 0) {
+        n++;
+    }
+
+    return n;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_cmdq_move(ringbuffer_t* rb, void* dst) {
+
+    if (rb == 0 || dst == 0) {
+        return 0;
+    }
+
+    const ringbuffer_cmdq_ops_t* ops;
+    size_t size = ringbuffer_cmdq_get_header(rb, &ops);
+
+    if (rb->len == 0) {
+        /* >>> Queue is empty >>> */
+        return 0;
+    }
+
+    void* obj = rb->buffer + rb->ir + RINGBUFFER_CMDQ_ALIGN;
+
+    if (ops->move != 0) {
+        /* Move object out and destroy what's left behind */
+        ops->move(dst, obj);
+        if (ops->destroy != 0) {
+            ops->destroy(obj);
+        }
+    } else {
+        /* Relocate object bitwise (no destructor call; the caller owns
+         * it now) */
+        memcpy(dst, obj, size);
+    }
+
+    ringbuffer_discard(rb, RINGBUFFER_CMDQ_ALIGN + size);
+
+    return size;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_cmdq_discard(ringbuffer_t* rb) {
+
+    if (rb == 0) {
+        return 0;
+    }
+
+    const ringbuffer_cmdq_ops_t* ops;
+    size_t size = ringbuffer_cmdq_get_header(rb, &ops);
+
+    if (rb->len == 0) {
+        /* >>> Queue is empty >>> */
+        return 0;
+    }
+
+    if (ops->destroy != 0) {
+        ops->destroy(rb->buffer + rb->ir + RINGBUFFER_CMDQ_ALIGN);
+    }
+
+    ringbuffer_discard(rb, RINGBUFFER_CMDQ_ALIGN + size);
+
+    return 1;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_cmdq_clear(ringbuffer_t* rb) {
+
+    int n = 0;
+
+    while (ringbuffer_cmdq_discard(rb) > 0) {
+        n++;
+    }
+
+    return n;
+}
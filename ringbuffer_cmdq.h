@@ -0,0 +1,123 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef RINGBUFFER_CMDQ_H_
+#define RINGBUFFER_CMDQ_H_
+
+#include "ringbuffer.h"
+
+
+/*
+ * Alignment of entries (and objects) in a command queue relative to the
+ * start of the buffer. Also the size of an entry header, which holds the
+ * block length and the pointer to the entry's operations.
+ */
+#define RINGBUFFER_CMDQ_ALIGN 16
+
+
+/*
+ * Operations of an entry type in a command queue
+ */
+typedef struct {
+
+    /* executes the object (may be 0 for pure messages) */
+    void (*invoke)(void* obj);
+
+    /* moves the object from <src> to <dst>, leaving <src> destructible
+     * (0 means bitwise move) */
+    void (*move)(void* dst, void* src);
+
+    /* releases resources held by the object (may be 0) */
+    void (*destroy)(void* obj);
+
+} ringbuffer_cmdq_ops_t;
+
+
+/* ========================================================================= */
+
+/*
+ * Sets up ringbuffer <rb> as a command queue in <memlen> bytes at <mem>. For
+ * objects to be aligned, <mem> must be aligned to RINGBUFFER_CMDQ_ALIGN.
+ * Each entry is a regular block (see ringbuffer_write_block) that never wraps
+ * around the end of the buffer, so objects are used in place.
+ */
+int ringbuffer_cmdq_init(ringbuffer_t* rb, uint8_t* mem, size_t memlen);
+
+
+/*
+ * Appends an entry of type <ops> with an object of <size> bytes and returns
+ * a pointer to the (uninitialized) object for in-place construction, or 0
+ * if there is not enough space.
+ */
+void* ringbuffer_cmdq_emplace(ringbuffer_t* rb,
+        const ringbuffer_cmdq_ops_t* ops, size_t size);
+
+
+/*
+ * Returns a pointer to the oldest object (and its type via <ops> if not 0),
+ * or 0 if the queue is empty.
+ */
+void* ringbuffer_cmdq_front(
+        ringbuffer_t* rb, const ringbuffer_cmdq_ops_t** ops);
+
+
+/*
+ * Invokes and destroys the oldest entry in place. Returns 1 if an entry has
+ * been invoked, or 0 if the queue is empty.
+ */
+int ringbuffer_cmdq_invoke(ringbuffer_t* rb);
+
+
+/*
+ * Invokes and destroys all entries (including those appended meanwhile).
+ * Returns the number of entries invoked.
+ */
+int ringbuffer_cmdq_run(ringbuffer_t* rb);
+
+
+/*
+ * Moves the oldest object to <dst> (which must be able to hold it) and
+ * removes the entry. With a move function, the moved-from object is
+ * destroyed in the queue afterwards (as with ringbuffer_objq_pop()); without
+ * one, the object is copied bitwise and not destroyed. Returns the size of
+ * the object's storage, or 0 if the queue is empty.
+ */
+int ringbuffer_cmdq_move(ringbuffer_t* rb, void* dst);
+
+
+/*
+ * Destroys and removes the oldest entry. Returns 1 if an entry has been
+ * removed, or 0 if the queue is empty.
+ */
+int ringbuffer_cmdq_discard(ringbuffer_t* rb);
+
+
+/*
+ * Destroys and removes all entries. Returns the number of entries removed.
+ */
+int ringbuffer_cmdq_clear(ringbuffer_t* rb);
+
+#endif
@@ -0,0 +1,251 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "ringbuffer_compact.h"
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void ringbuffer_compact_load(ringbuffer_compact_t* rbc, ringbuffer_t* rb) {
+
+    /* Describe compact ringbuffer as regular one (no copy of content) */
+    rb->buffer = rbc->buffer;
+    rb->size = rbc->size;
+    rb->len = rbc->len;
+    rb->iw = rbc->iw;
+    rb->ir = rbc->ir;
+    rb->written = 0;
+    rb->stream_threshold = RINGBUFFER_STREAM_THRESHOLD;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void ringbuffer_compact_store(ringbuffer_compact_t* rbc, ringbuffer_t* rb) {
+
+    /* Indices never exceed size which fits into the index width */
+    rbc->len = (rb_compact_index_t)rb->len;
+    rbc->iw = (rb_compact_index_t)rb->iw;
+    rbc->ir = (rb_compact_index_t)rb->ir;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+ringbuffer_compact_t* ringbuffer_compact_init(void* mem, size_t memlen) {
+
+    /* Sanity check: make sure input pointer is ok */
+    if (mem == 0 || memlen < sizeof(ringbuffer_compact_t)) {
+        /* >>> Invalid pointer to memory or too little memory >>> */
+        return 0;
+    }
+
+    size_t size = memlen - sizeof(ringbuffer_compact_t);
+    if (size > (rb_compact_index_t)-1) {
+        /* >>> Capacity not representable by indices >>> */
+        return 0;
+    }
+
+    ringbuffer_compact_t* rbc = (ringbuffer_compact_t*)mem;
+    rbc->size = (rb_compact_index_t)size;
+    rbc->len = 0;
+    rbc->iw = 0;
+    rbc->ir = 0;
+
+    return rbc;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_compact_get_length(ringbuffer_compact_t* rbc) {
+
+    if (rbc == 0) {
+        return -1;
+    }
+
+    return rbc->len;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_compact_get_space(ringbuffer_compact_t* rbc) {
+
+    if (rbc == 0) {
+        return -1;
+    }
+
+    return rbc->size - rbc->len;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_compact_clear(ringbuffer_compact_t* rbc) {
+
+    if (rbc == 0) {
+        return -1;
+    }
+
+    rbc->len = 0;
+    rbc->iw = 0;
+    rbc->ir = 0;
+
+    return rbc->size;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_compact_write(
+        ringbuffer_compact_t* rbc, const uint8_t* data, size_t len) {
+
+    if (rbc == 0) {
+        return -1;
+    }
+
+    ringbuffer_t rb;
+    ringbuffer_compact_load(rbc, &rb);
+    int ret = ringbuffer_write(&rb, data, len);
+    ringbuffer_compact_store(rbc, &rb);
+
+    return ret;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_compact_write_all(
+        ringbuffer_compact_t* rbc, const uint8_t* data, size_t len) {
+
+    if (rbc == 0) {
+        return -1;
+    }
+
+    ringbuffer_t rb;
+    ringbuffer_compact_load(rbc, &rb);
+    int ret = ringbuffer_write_all(&rb, data, len);
+    ringbuffer_compact_store(rbc, &rb);
+
+    return ret;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_compact_read(
+        ringbuffer_compact_t* rbc, uint8_t* data, size_t len) {
+
+    if (rbc == 0) {
+        return -1;
+    }
+
+    ringbuffer_t rb;
+    ringbuffer_compact_load(rbc, &rb);
+    int ret = ringbuffer_read(&rb, data, len);
+    ringbuffer_compact_store(rbc, &rb);
+
+    return ret;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_compact_peek(
+        ringbuffer_compact_t* rbc, uint8_t* data, size_t len) {
+
+    if (rbc == 0) {
+        return -1;
+    }
+
+    ringbuffer_t rb;
+    ringbuffer_compact_load(rbc, &rb);
+
+    return ringbuffer_peek(&rb, data, len);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_compact_peek_offset(ringbuffer_compact_t* rbc,
+        size_t offset, uint8_t* data, size_t len) {
+
+    if (rbc == 0) {
+        return -1;
+    }
+
+    ringbuffer_t rb;
+    ringbuffer_compact_load(rbc, &rb);
+
+    return ringbuffer_peek_offset(&rb, offset, data, len);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_compact_find(ringbuffer_compact_t* rbc,
+        size_t offset, uint8_t* data, size_t len) {
+
+    if (rbc == 0) {
+        return -1;
+    }
+
+    ringbuffer_t rb;
+    ringbuffer_compact_load(rbc, &rb);
+
+    return ringbuffer_find(&rb, offset, data, len);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_compact_discard(ringbuffer_compact_t* rbc, size_t len) {
+
+    if (rbc == 0) {
+        return -1;
+    }
+
+    ringbuffer_t rb;
+    ringbuffer_compact_load(rbc, &rb);
+    int ret = ringbuffer_discard(&rb, len);
+    ringbuffer_compact_store(rbc, &rb);
+
+    return ret;
+}
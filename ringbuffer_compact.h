@@ -0,0 +1,125 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef RINGBUFFER_COMPACT_H_
+#define RINGBUFFER_COMPACT_H_
+
+#include "ringbuffer.h"
+
+
+/*
+ * Width of the indices of compact ringbuffers (16 or 32 bits). This limits
+ * the capacity of a compact ringbuffer to 2^16-1 or 2^32-1 bytes.
+ */
+#ifndef RINGBUFFER_COMPACT_INDEX_BITS
+#define RINGBUFFER_COMPACT_INDEX_BITS 32
+#endif
+
+#if RINGBUFFER_COMPACT_INDEX_BITS == 16
+typedef uint16_t rb_compact_index_t;
+#else
+typedef uint32_t rb_compact_index_t;
+#endif
+
+
+/*
+ * A ringbuffer with narrow indices and its buffer stored inline, i.e. state
+ * and content live in a single allocation (no pointer to follow)
+ */
+typedef struct {
+
+    /* size of buffer */
+    rb_compact_index_t size;
+
+    /* length of content */
+    rb_compact_index_t len;
+
+    /* writing index */
+    rb_compact_index_t iw;
+
+    /* reading index */
+    rb_compact_index_t ir;
+
+    /* actual buffer */
+    uint8_t buffer[];
+
+} ringbuffer_compact_t;
+
+
+/*
+ * Number of bytes to allocate for a compact ringbuffer of <capacity> bytes
+ */
+#define RINGBUFFER_COMPACT_SIZEOF(capacity) \
+    (sizeof(ringbuffer_compact_t) + (capacity))
+
+
+/* ========================================================================= */
+
+/*
+ * Sets up a compact ringbuffer in <memlen> bytes at <mem> (state and
+ * buffer). Returns a pointer to the ringbuffer, or 0 if <memlen> is too
+ * small or the resulting capacity exceeds the index width.
+ */
+ringbuffer_compact_t* ringbuffer_compact_init(void* mem, size_t memlen);
+
+
+/*
+ * The following functions behave like their ringbuffer_* counterparts. Each
+ * call operates through a temporary ringbuffer_t describing the compact
+ * ringbuffer, so features tied to a ringbuffer_t do not cover compact
+ * ringbuffers: a trace hook sees a different ringbuffer on every call, the
+ * written counter restarts at 0 on every call (no replicas or other
+ * observers relying on it) and writes use the build's default stream
+ * threshold (RINGBUFFER_STREAM_THRESHOLD).
+ */
+
+int ringbuffer_compact_get_length(ringbuffer_compact_t* rbc);
+
+int ringbuffer_compact_get_space(ringbuffer_compact_t* rbc);
+
+int ringbuffer_compact_clear(ringbuffer_compact_t* rbc);
+
+int ringbuffer_compact_write(
+        ringbuffer_compact_t* rbc, const uint8_t* data, size_t len);
+
+int ringbuffer_compact_write_all(
+        ringbuffer_compact_t* rbc, const uint8_t* data, size_t len);
+
+int ringbuffer_compact_read(
+        ringbuffer_compact_t* rbc, uint8_t* data, size_t len);
+
+int ringbuffer_compact_peek(
+        ringbuffer_compact_t* rbc, uint8_t* data, size_t len);
+
+int ringbuffer_compact_peek_offset(ringbuffer_compact_t* rbc,
+        size_t offset, uint8_t* data, size_t len);
+
+int ringbuffer_compact_find(ringbuffer_compact_t* rbc,
+        size_t offset, uint8_t* data, size_t len);
+
+int ringbuffer_compact_discard(ringbuffer_compact_t* rbc, size_t len);
+
+#endif
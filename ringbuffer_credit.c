@@ -0,0 +1,222 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+
+#include "ringbuffer_credit.h"
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_credit_init(
+        ringbuffer_credit_t* c, ringbuffer_t* rb, size_t quantum) {
+
+    if (c == 0 || rb == 0) {
+        /* >>> Invalid pointer to credit state or ringbuffer >>> */
+        return -1;
+    }
+
+    if (quantum > rb->size) {
+        /* >>> Batches larger than the ringbuffer could never fill up >>> */
+        return -1;
+    }
+
+    c->rb = rb;
+    c->pending = 0;
+    c->quantum = quantum;
+    __atomic_store_n(&c->credits, rb->size - rb->len, __ATOMIC_RELEASE);
+
+    return rb->size - rb->len;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_credit_available(ringbuffer_credit_t* c) {
+
+    if (c == 0) {
+        /* >>> Invalid pointer to credit state >>> */
+        return -1;
+    }
+
+    return __atomic_load_n(&c->credits, __ATOMIC_ACQUIRE);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_credit_write(
+        ringbuffer_credit_t* c, const uint8_t* data, size_t len) {
+
+    /* Credits only grow behind the producer's back, so checking them
+     * before consuming them is safe */
+    if (c == 0 || len > __atomic_load_n(&c->credits, __ATOMIC_ACQUIRE)) {
+        /* >>> Invalid pointer to credit state or not enough credits >>> */
+        return -1;
+    }
+
+    int n = ringbuffer_write_all(c->rb, data, len);
+    if (n > 0) {
+        __atomic_fetch_sub(&c->credits, (size_t)n, __ATOMIC_ACQ_REL);
+    }
+
+    return n;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_credit_write_block(
+        ringbuffer_credit_t* c, const uint8_t* block, size_t len) {
+
+    if (c == 0 || len + sizeof(size_t)
+            > __atomic_load_n(&c->credits, __ATOMIC_ACQUIRE)) {
+        /* >>> Invalid pointer to credit state or not enough credits >>> */
+        return -1;
+    }
+
+    int n = ringbuffer_write_block(c->rb, block, len);
+    if (n > 0) {
+        __atomic_fetch_sub(&c->credits, (size_t)n, __ATOMIC_ACQ_REL);
+    }
+
+    return n;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_credit_read(ringbuffer_credit_t* c, uint8_t* data, size_t len) {
+
+    if (c == 0) {
+        /* >>> Invalid pointer to credit state >>> */
+        return -1;
+    }
+
+    int n = ringbuffer_read(c->rb, data, len);
+    if (n > 0) {
+        ringbuffer_credit_release(c, n);
+    }
+
+    return n;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_credit_read_block(
+        ringbuffer_credit_t* c, uint8_t* block, size_t len) {
+
+    if (c == 0) {
+        /* >>> Invalid pointer to credit state >>> */
+        return -1;
+    }
+
+    /* The space freed includes the block header (and zero-length blocks
+     * free space, too), so determine it from the content length */
+    size_t before = c->rb->len;
+    int n = ringbuffer_read_block(c->rb, block, len);
+    ringbuffer_credit_release(c, before - c->rb->len);
+
+    return n;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_credit_release(ringbuffer_credit_t* c, size_t len) {
+
+    if (c == 0) {
+        /* >>> Invalid pointer to credit state >>> */
+        return -1;
+    }
+
+    /* <pending> is only touched by the consumer */
+    c->pending += len;
+
+    /* Grant freed space in batches, but everything once the consumer has
+     * drained the ringbuffer: no more space will be freed until the
+     * producer writes again, which it may be waiting to do */
+    if (c->pending >= c->quantum || c->rb->len == 0) {
+        size_t grant = c->pending;
+        c->pending = 0;
+        return __atomic_add_fetch(&c->credits, grant, __ATOMIC_ACQ_REL);
+    }
+
+    return __atomic_load_n(&c->credits, __ATOMIC_ACQUIRE);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_credit_forward(
+        ringbuffer_credit_t* upstream, ringbuffer_credit_t* downstream) {
+
+    if (upstream == 0 || downstream == 0) {
+        /* >>> Invalid pointer to credit state(s) >>> */
+        return -1;
+    }
+
+    ringbuffer_t* rb = upstream->rb;
+    size_t credits = __atomic_load_n(&downstream->credits, __ATOMIC_ACQUIRE);
+    size_t forwarded = 0;
+
+    /* Move complete blocks (header and payload) as long as credits last */
+    while (rb->len >= sizeof(size_t)) {
+        int bl = ringbuffer_peek_block_length(rb);
+        if (bl < 0) {
+            /* >>> Incomplete block >>> */
+            break;
+        }
+        size_t total = (size_t)bl + sizeof(size_t);
+        if (total > credits - forwarded) {
+            /* >>> Not enough credits for the next block >>> */
+            break;
+        }
+        if (ringbuffer_copy(downstream->rb, rb, 0, total) < 0) {
+            /* >>> Downstream ringbuffer out of sync with credits >>> */
+            break;
+        }
+        ringbuffer_discard(rb, total);
+        forwarded += total;
+    }
+
+    if (forwarded > 0) {
+        __atomic_fetch_sub(&downstream->credits, forwarded, __ATOMIC_ACQ_REL);
+
+        /* The space freed upstream goes back to its producer */
+        ringbuffer_credit_release(upstream, forwarded);
+    }
+
+    return forwarded;
+}
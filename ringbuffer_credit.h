@@ -0,0 +1,134 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+
+#ifndef RINGBUFFER_CREDIT_H_
+#define RINGBUFFER_CREDIT_H_
+
+#include "ringbuffer.h"
+
+
+/*
+ * Credit-based flow control for a ringbuffer fed by an upstream producer
+ * (e.g. the previous stage of a chain of ringbuffers). The producer may only
+ * write as many bytes as it holds credits for, so writes never truncate.
+ * Space freed by the consumer is granted back as credits in batches of at
+ * least <quantum> bytes, letting the producer batch its writes accordingly
+ * (see ringbuffer_credit_forward()). Once the consumer has drained the
+ * ringbuffer, all freed space is granted regardless of the quantum, so a
+ * producer waiting for more credits than it holds never stalls.
+ *
+ * The credit counters are updated atomically, so the producer and the
+ * consumer may check and update credits from different threads. Accesses to
+ * the ringbuffer itself must be serialized by the caller as usual.
+ */
+typedef struct {
+
+    /* the (downstream) ringbuffer */
+    ringbuffer_t* rb;
+
+    /* bytes the producer may write */
+    size_t credits;
+
+    /* bytes freed by the consumer but not granted yet */
+    size_t pending;
+
+    /* minimum number of bytes granted at once */
+    size_t quantum;
+
+} ringbuffer_credit_t;
+
+
+/* ========================================================================= */
+
+/*
+ * Sets up credit-based flow control <c> for ringbuffer <rb>, initially
+ * granting its current space. Freed space is granted in batches of at least
+ * <quantum> bytes (0 grants every byte immediately), which must not exceed
+ * the ringbuffer's size. Returns the credits granted, or -1 on invalid input.
+ */
+int ringbuffer_credit_init(
+        ringbuffer_credit_t* c, ringbuffer_t* rb, size_t quantum);
+
+
+/*
+ * Returns the number of bytes the producer may currently write.
+ */
+int ringbuffer_credit_available(ringbuffer_credit_t* c);
+
+
+/*
+ * Writes <len> bytes if the producer holds enough credits (all or nothing).
+ * Returns the number of bytes written, or -1 if credits are insufficient.
+ */
+int ringbuffer_credit_write(
+        ringbuffer_credit_t* c, const uint8_t* data, size_t len);
+
+
+/*
+ * Writes a block of <len> bytes if the producer holds enough credits for
+ * the block including its header. Returns the number of bytes written
+ * including the header, or -1 if credits are insufficient.
+ */
+int ringbuffer_credit_write_block(
+        ringbuffer_credit_t* c, const uint8_t* block, size_t len);
+
+
+/*
+ * Reads up to <len> bytes on behalf of the consumer and returns the space
+ * freed to the producer. Returns the number of bytes read.
+ */
+int ringbuffer_credit_read(ringbuffer_credit_t* c, uint8_t* data, size_t len);
+
+
+/*
+ * Reads the next block on behalf of the consumer (see ringbuffer_read_block())
+ * and returns the space freed to the producer. Returns the payload length.
+ */
+int ringbuffer_credit_read_block(
+        ringbuffer_credit_t* c, uint8_t* block, size_t len);
+
+
+/*
+ * Returns <len> bytes of space freed by the consumer by other means (e.g.
+ * ringbuffer_discard()) to the producer.
+ */
+int ringbuffer_credit_release(ringbuffer_credit_t* c, size_t len);
+
+
+/*
+ * Forwards whole blocks from the front of the ringbuffer behind <upstream>
+ * to the ringbuffer behind <downstream> for as long as <downstream> holds
+ * enough credits for the next block including its header. Blocks are moved
+ * as a batch without intermediate copies, and the space they freed upstream
+ * is released to <upstream>'s producer (as by ringbuffer_credit_release()).
+ * Returns the number of bytes forwarded including headers, or -1 on invalid
+ * input.
+ */
+int ringbuffer_credit_forward(
+        ringbuffer_credit_t* upstream, ringbuffer_credit_t* downstream);
+
+#endif
@@ -0,0 +1,174 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "ringbuffer_deque.h"
+#include <string.h>
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static uint8_t* ringbuffer_deque_slot(ringbuffer_deque_t* dq, int64_t i) {
+
+    /* Indices grow monotonically and are wrapped onto the slots here */
+    return dq->buffer + (size_t)((uint64_t)i % dq->size) * dq->esize;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_deque_init(ringbuffer_deque_t* dq,
+        uint8_t* mem, size_t memlen, size_t esize) {
+
+    /* Sanity check: make sure input pointers are ok */
+    if (dq == 0 || mem == 0 || esize == 0 || memlen < esize) {
+        /* >>> Invalid pointer(s) or no space for a single record >>> */
+        return -1;
+    }
+
+    dq->buffer = mem;
+    dq->size = memlen / esize;
+    dq->esize = esize;
+    dq->top = 0;
+    dq->bottom = 0;
+
+    return dq->size;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_deque_get_length(ringbuffer_deque_t* dq) {
+
+    if (dq == 0) {
+        return -1;
+    }
+
+    int64_t b = __atomic_load_n(&dq->bottom, __ATOMIC_ACQUIRE);
+    int64_t t = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE);
+
+    return (b > t) ? (int)(b - t) : 0;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_deque_push(ringbuffer_deque_t* dq, const uint8_t* record) {
+
+    if (dq == 0 || record == 0) {
+        /* >>> Invalid pointer to deque or record >>> */
+        return -1;
+    }
+
+    /* Only the owner writes <bottom>, so a relaxed load is sufficient */
+    int64_t b = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED);
+    int64_t t = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE);
+
+    if (b - t >= (int64_t)dq->size) {
+        /* >>> Deque is full >>> */
+        return -1;
+    }
+
+    memcpy(ringbuffer_deque_slot(dq, b), record, dq->esize);
+
+    /* Publish the record to thieves */
+    __atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELEASE);
+
+    return dq->esize;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_deque_pop(ringbuffer_deque_t* dq, uint8_t* record) {
+
+    if (dq == 0 || record == 0) {
+        return 0;
+    }
+
+    /* Reserve the bottom record before looking at <top> */
+    int64_t b = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&dq->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t t = __atomic_load_n(&dq->top, __ATOMIC_RELAXED);
+
+    if (t > b) {
+        /* >>> Deque is empty >>> */
+        __atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+
+    memcpy(record, ringbuffer_deque_slot(dq, b), dq->esize);
+
+    if (t < b) {
+        /* >>> More than one record left: no race with thieves >>> */
+        return dq->esize;
+    }
+
+    /* Last record: race against thieves by advancing <top> */
+    int won = __atomic_compare_exchange_n(&dq->top, &t, t + 1,
+            0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+
+    return won ? (int)dq->esize : 0;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_deque_steal(ringbuffer_deque_t* dq, uint8_t* record) {
+
+    if (dq == 0 || record == 0) {
+        return 0;
+    }
+
+    int64_t t = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t b = __atomic_load_n(&dq->bottom, __ATOMIC_ACQUIRE);
+
+    if (t >= b) {
+        /* >>> Deque is empty >>> */
+        return 0;
+    }
+
+    /* The slot at <top> cannot be overwritten by the owner
+     * before <top> has advanced, so copy it out first */
+    memcpy(record, ringbuffer_deque_slot(dq, t), dq->esize);
+
+    if (!__atomic_compare_exchange_n(&dq->top, &t, t + 1,
+            0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        /* >>> Lost the race against another thief or the owner >>> */
+        return -2;
+    }
+
+    return dq->esize;
+}
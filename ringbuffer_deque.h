@@ -0,0 +1,97 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef RINGBUFFER_DEQUE_H_
+#define RINGBUFFER_DEQUE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/*
+ * A Chase-Lev work-stealing deque of fixed-size records. The owner thread
+ * pushes and pops records at the bottom, any number of thief threads steal
+ * records from the top. The capacity is fixed by the memory provided at
+ * initialization (the deque does not grow).
+ */
+typedef struct {
+
+    /* pointer to actual buffer */
+    uint8_t* buffer;
+
+    /* number of record slots in buffer */
+    size_t size;
+
+    /* size of a record */
+    size_t esize;
+
+    /* index of the oldest record (advanced by thieves) */
+    int64_t top;
+
+    /* index one past the newest record (owned by the owner thread) */
+    int64_t bottom;
+
+} ringbuffer_deque_t;
+
+
+/* ========================================================================= */
+
+/*
+ * Sets up a deque of <esize>-byte records in <memlen> bytes at <mem>.
+ * Returns the number of record slots.
+ */
+int ringbuffer_deque_init(ringbuffer_deque_t* dq,
+        uint8_t* mem, size_t memlen, size_t esize);
+
+
+/*
+ * Returns the (approximate if called concurrently) number of records.
+ */
+int ringbuffer_deque_get_length(ringbuffer_deque_t* dq);
+
+
+/*
+ * Owner only: pushes a record at the bottom. Returns the record size,
+ * or -1 if the deque is full.
+ */
+int ringbuffer_deque_push(ringbuffer_deque_t* dq, const uint8_t* record);
+
+
+/*
+ * Owner only: pops the newest record from the bottom. Returns the record
+ * size, or 0 if the deque is empty.
+ */
+int ringbuffer_deque_pop(ringbuffer_deque_t* dq, uint8_t* record);
+
+
+/*
+ * Any thread: steals the oldest record from the top. Returns the record
+ * size, 0 if the deque is empty, or -2 if another thread won the race for
+ * the record (in which case the caller may retry).
+ */
+int ringbuffer_deque_steal(ringbuffer_deque_t* dq, uint8_t* record);
+
+#endif
@@ -0,0 +1,366 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+
+#include "ringbuffer_dfa.h"
+#include <string.h>
+
+#if RINGBUFFER_DFA_MAX_STATES > 256
+#error "RINGBUFFER_DFA_MAX_STATES must not exceed 256"
+#endif
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static int ringbuffer_dfa_hex(char c) {
+
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+
+/*
+ * Parses a (possibly escaped) byte at <*p> and advances <*p> past it.
+ * Returns the byte value or -1 if the pattern is malformed.
+ * ___________________________________________________________________________
+ */
+static int ringbuffer_dfa_parse_byte(const char** p) {
+
+    const char* s = *p;
+
+    if (*s == '\0') {
+        return -1;
+    }
+    if (*s != '\\') {
+        *p = s + 1;
+        return (uint8_t)*s;
+    }
+
+    /* Escape sequence */
+    switch (s[1]) {
+    case '\0':
+        return -1;
+    case 'n':
+        *p = s + 2;
+        return '\n';
+    case 'r':
+        *p = s + 2;
+        return '\r';
+    case 't':
+        *p = s + 2;
+        return '\t';
+    case 'x': {
+        int hi = ringbuffer_dfa_hex(s[2]);
+        int lo = (hi < 0) ? -1 : ringbuffer_dfa_hex(s[3]);
+        if (lo < 0) {
+            return -1;
+        }
+        *p = s + 4;
+        return (hi << 4) | lo;
+    }
+    default:
+        *p = s + 2;
+        return (uint8_t)s[1];
+    }
+}
+
+
+/*
+ * Parses a character class (starting after the opening bracket) into
+ * <map> and advances <*p> past the closing bracket.
+ * ___________________________________________________________________________
+ */
+static int ringbuffer_dfa_parse_class(const char** p, uint8_t map[32]) {
+
+    int negate = 0;
+    int first = 1;
+
+    memset(map, 0, 32);
+
+    if (**p == '^') {
+        negate = 1;
+        (*p)++;
+    }
+
+    /* A ']' right at the start is a literal */
+    while (**p != ']' || first) {
+
+        int lo = ringbuffer_dfa_parse_byte(p);
+        int hi = lo;
+
+        if (lo < 0) {
+            /* >>> Unterminated class or bad escape >>> */
+            return -1;
+        }
+        if ((*p)[0] == '-' && (*p)[1] != ']' && (*p)[1] != '\0') {
+            (*p)++;
+            hi = ringbuffer_dfa_parse_byte(p);
+            if (hi < lo) {
+                /* >>> Bad escape or inverted range >>> */
+                return -1;
+            }
+        }
+        for (int b = lo; b <= hi; b++) {
+            map[b >> 3] |= (uint8_t)(1 << (b & 7));
+        }
+        first = 0;
+    }
+    (*p)++;
+
+    if (negate) {
+        for (int i = 0; i < 32; i++) {
+            map[i] = (uint8_t)~map[i];
+        }
+    }
+
+    return 0;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_dfa_compile(ringbuffer_dfa_t* dfa, const char* pattern) {
+
+    if (dfa == 0 || pattern == 0) {
+        /* >>> Invalid pointer to DFA or pattern >>> */
+        return -1;
+    }
+
+    /* Glushkov automaton: one NFA state per position (i.e. character or
+     * class) of the pattern. Sets of positions are bitmasks. */
+    uint64_t classes[256];
+    uint64_t follow[RINGBUFFER_DFA_MAX_POSITIONS];
+    uint8_t nullable[RINGBUFFER_DFA_MAX_POSITIONS];
+    uint8_t repeat[RINGBUFFER_DFA_MAX_POSITIONS];
+    size_t npos = 0;
+
+    memset(classes, 0, sizeof(classes));
+
+    while (*pattern != '\0') {
+
+        uint8_t map[32];
+
+        if (npos == RINGBUFFER_DFA_MAX_POSITIONS) {
+            /* >>> Pattern too long >>> */
+            return -1;
+        }
+
+        if (*pattern == '.') {
+            memset(map, 0xFF, sizeof(map));
+            pattern++;
+        } else if (*pattern == '[') {
+            pattern++;
+            if (ringbuffer_dfa_parse_class(&pattern, map) < 0) {
+                return -1;
+            }
+        } else if (*pattern == '?' || *pattern == '*' || *pattern == '+') {
+            /* >>> Quantifier without operand >>> */
+            return -1;
+        } else {
+            int b = ringbuffer_dfa_parse_byte(&pattern);
+            if (b < 0) {
+                return -1;
+            }
+            memset(map, 0, sizeof(map));
+            map[b >> 3] = (uint8_t)(1 << (b & 7));
+        }
+
+        nullable[npos] = (*pattern == '?' || *pattern == '*');
+        repeat[npos] = (*pattern == '*' || *pattern == '+');
+        if (*pattern == '?' || *pattern == '*' || *pattern == '+') {
+            pattern++;
+        }
+
+        for (int b = 0; b < 256; b++) {
+            if (map[b >> 3] & (1 << (b & 7))) {
+                classes[b] |= (uint64_t)1 << npos;
+            }
+        }
+        npos++;
+    }
+
+    /* Positions that may start a match: up to the first mandatory one */
+    uint64_t first = 0;
+    size_t i = 0;
+    do {
+        if (i == npos) {
+            /* >>> Pattern matches the empty string >>> */
+            return -1;
+        }
+        first |= (uint64_t)1 << i;
+    } while (nullable[i++]);
+
+    /* Positions that may end a match: back to the last mandatory one */
+    uint64_t last = 0;
+    i = npos;
+    do {
+        last |= (uint64_t)1 << --i;
+    } while (nullable[i] && i > 0);
+
+    /* Positions that may follow a position: itself if repeated, then the
+     * next ones up to (and including) the next mandatory one */
+    for (i = 0; i < npos; i++) {
+        follow[i] = repeat[i] ? ((uint64_t)1 << i) : 0;
+        for (size_t j = i + 1; j < npos; j++) {
+            follow[i] |= (uint64_t)1 << j;
+            if (!nullable[j]) {
+                break;
+            }
+        }
+    }
+
+    /* Subset construction; DFA state 0 is the empty set of positions. Since
+     * matches may start anywhere, <first> is a candidate in every state. */
+    uint64_t sets[RINGBUFFER_DFA_MAX_STATES];
+    sets[0] = 0;
+    dfa->accept[0] = 0;
+    dfa->nstates = 1;
+
+    for (size_t s = 0; s < dfa->nstates; s++) {
+
+        uint64_t candidates = first;
+        for (i = 0; i < npos; i++) {
+            if (sets[s] & ((uint64_t)1 << i)) {
+                candidates |= follow[i];
+            }
+        }
+
+        for (int b = 0; b < 256; b++) {
+
+            uint64_t t = candidates & classes[b];
+
+            size_t n;
+            for (n = 0; n < dfa->nstates && sets[n] != t; n++) {
+            }
+            if (n == dfa->nstates) {
+                if (n == RINGBUFFER_DFA_MAX_STATES) {
+                    /* >>> Too many states >>> */
+                    return -1;
+                }
+                sets[n] = t;
+                dfa->accept[n] = (t & last) != 0;
+                dfa->nstates++;
+            }
+            dfa->next[s][b] = (uint8_t)n;
+        }
+    }
+
+    return dfa->nstates;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_dfa_match_init(
+        ringbuffer_dfa_match_t* m, const ringbuffer_dfa_t* dfa) {
+
+    if (m == 0 || dfa == 0) {
+        /* >>> Invalid pointer to match state or DFA >>> */
+        return -1;
+    }
+
+    m->dfa = dfa;
+    m->offset = 0;
+    m->state = 0;
+
+    return 0;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_dfa_match(ringbuffer_dfa_match_t* m,
+        ringbuffer_t* rb, size_t* ends, size_t max) {
+
+    if (m == 0 || rb == 0 || (ends == 0 && max > 0) || m->offset > rb->len) {
+        /* >>> Invalid pointer(s) or content discarded behind our back >>> */
+        return -1;
+    }
+
+    ringbuffer_segments_t seg;
+    ringbuffer_get_segments(rb, m->offset, rb->len - m->offset, &seg);
+
+    const ringbuffer_dfa_t* dfa = m->dfa;
+    uint8_t state = m->state;
+    size_t n = 0;
+
+    for (int i = 0; i < 2; i++) {
+
+        /* Run the DFA over each linear region in place; the state carries
+         * a partial match over into the next region (or call) */
+        const uint8_t* p = seg.data[i];
+        size_t j = 0;
+
+        for (; j < seg.len[i]; j++) {
+            uint8_t next = dfa->next[state][p[j]];
+            if (dfa->accept[next]) {
+                if (n == max) {
+                    /* >>> No more room: resume at this byte next time >>> */
+                    break;
+                }
+                ends[n++] = m->offset + j + 1;
+            }
+            state = next;
+        }
+
+        m->offset += j;
+
+        if (j < seg.len[i]) {
+            break;
+        }
+    }
+
+    m->state = state;
+
+    return n;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_dfa_consume(ringbuffer_dfa_match_t* m, size_t len) {
+
+    if (m == 0 || len > m->offset) {
+        /* >>> Invalid pointer or content not matched yet >>> */
+        return -1;
+    }
+
+    m->offset -= len;
+
+    return len;
+}
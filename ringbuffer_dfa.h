@@ -0,0 +1,114 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+
+#ifndef RINGBUFFER_DFA_H_
+#define RINGBUFFER_DFA_H_
+
+#include "ringbuffer.h"
+
+
+/* Maximum number of DFA states (at most 256) */
+#ifndef RINGBUFFER_DFA_MAX_STATES
+#define RINGBUFFER_DFA_MAX_STATES 64
+#endif
+
+/* Maximum number of character positions in a pattern */
+#define RINGBUFFER_DFA_MAX_POSITIONS 64
+
+
+/*
+ * A deterministic automaton compiled from a pattern. Patterns are sequences
+ * of literals, escapes (\n, \r, \t, \xHH, or a quoted character), '.' (any
+ * byte) and character classes ([abc], [a-z], [^...]), each optionally
+ * followed by '?', '*' or '+'. Matches may start at any offset.
+ */
+typedef struct {
+
+    /* transition table */
+    uint8_t next[RINGBUFFER_DFA_MAX_STATES][256];
+
+    /* non-zero for states in which a match ends */
+    uint8_t accept[RINGBUFFER_DFA_MAX_STATES];
+
+    /* number of states */
+    size_t nstates;
+
+} ringbuffer_dfa_t;
+
+
+/*
+ * The state of matching a DFA against the content of a ringbuffer
+ */
+typedef struct {
+
+    /* the DFA to run */
+    const ringbuffer_dfa_t* dfa;
+
+    /* offset (relative to the read index) up to which content is matched */
+    size_t offset;
+
+    /* current DFA state */
+    uint8_t state;
+
+} ringbuffer_dfa_match_t;
+
+
+/* ========================================================================= */
+
+/*
+ * Compiles the null-terminated <pattern> into <dfa>. Returns the number of
+ * states, or -1 if the pattern is invalid, may match the empty string, or
+ * needs more than RINGBUFFER_DFA_MAX_STATES states.
+ */
+int ringbuffer_dfa_compile(ringbuffer_dfa_t* dfa, const char* pattern);
+
+
+/*
+ * Sets up <m> to run <dfa> over content from the read index onwards.
+ */
+int ringbuffer_dfa_match_init(
+        ringbuffer_dfa_match_t* m, const ringbuffer_dfa_t* dfa);
+
+
+/*
+ * Runs the DFA over the content of <rb> written since the previous call and
+ * stores the end offsets (one past the last byte) of (at most <max>) matches
+ * in <ends>. If <max> is reached, matching stops in front of the next match
+ * and continues from there on the next call. Returns the number of end
+ * offsets stored.
+ */
+int ringbuffer_dfa_match(ringbuffer_dfa_match_t* m,
+        ringbuffer_t* rb, size_t* ends, size_t max);
+
+
+/*
+ * Rebases <m> after <len> bytes of matched content have been read or
+ * discarded from the ringbuffer.
+ */
+int ringbuffer_dfa_consume(ringbuffer_dfa_match_t* m, size_t len);
+
+#endif
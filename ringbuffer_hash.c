@@ -0,0 +1,285 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+
+#include "ringbuffer_hash.h"
+#include <string.h>
+
+
+#define RINGBUFFER_HASH_P1 0x9E3779B185EBCA87ULL
+#define RINGBUFFER_HASH_P2 0xC2B2AE3D27D4EB4FULL
+#define RINGBUFFER_HASH_P3 0x165667B19E3779F9ULL
+#define RINGBUFFER_HASH_P4 0x85EBCA77C2B2AE63ULL
+#define RINGBUFFER_HASH_P5 0x27D4EB2F165667C5ULL
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static uint64_t ringbuffer_hash_rotl(uint64_t x, int r) {
+
+    return (x << r) | (x >> (64 - r));
+}
+
+
+/*
+ * Reads a little-endian 64-bit word (regardless of host byte order)
+ * ___________________________________________________________________________
+ */
+static uint64_t ringbuffer_hash_read64(const uint8_t* p) {
+
+    uint64_t x = 0;
+    for (int i = 7; i >= 0; i--) {
+        x = (x << 8) | p[i];
+    }
+
+    return x;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static uint32_t ringbuffer_hash_read32(const uint8_t* p) {
+
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8)
+            | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static uint64_t ringbuffer_hash_round(uint64_t acc, uint64_t input) {
+
+    acc += input * RINGBUFFER_HASH_P2;
+    acc = ringbuffer_hash_rotl(acc, 31);
+
+    return acc * RINGBUFFER_HASH_P1;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static uint64_t ringbuffer_hash_merge(uint64_t acc, uint64_t v) {
+
+    acc ^= ringbuffer_hash_round(0, v);
+
+    return acc * RINGBUFFER_HASH_P1 + RINGBUFFER_HASH_P4;
+}
+
+
+/*
+ * Consumes full 32-byte stripes of <data> and returns the number of bytes
+ * consumed.
+ * ___________________________________________________________________________
+ */
+static size_t ringbuffer_hash_stripes(
+        ringbuffer_hash_t* h, const uint8_t* data, size_t len) {
+
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32) {
+        for (int j = 0; j < 4; j++) {
+            h->v[j] = ringbuffer_hash_round(
+                    h->v[j], ringbuffer_hash_read64(data + i + 8 * j));
+        }
+    }
+
+    return i;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_hash_init(ringbuffer_hash_t* h, uint64_t seed) {
+
+    if (h == 0) {
+        /* >>> Invalid pointer to hash state >>> */
+        return -1;
+    }
+
+    h->v[0] = seed + RINGBUFFER_HASH_P1 + RINGBUFFER_HASH_P2;
+    h->v[1] = seed + RINGBUFFER_HASH_P2;
+    h->v[2] = seed;
+    h->v[3] = seed - RINGBUFFER_HASH_P1;
+    h->total = 0;
+    h->seed = seed;
+    h->memlen = 0;
+
+    return 0;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_hash_update(
+        ringbuffer_hash_t* h, const uint8_t* data, size_t len) {
+
+    if (h == 0 || (data == 0 && len > 0)) {
+        /* >>> Invalid pointer to hash state or data >>> */
+        return -1;
+    }
+
+    h->total += len;
+
+    if (h->memlen > 0) {
+
+        /* Complete a stripe buffered by a previous call first */
+        size_t n = 32 - h->memlen;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(h->mem + h->memlen, data, n);
+        h->memlen += n;
+        data += n;
+        len -= n;
+
+        if (h->memlen < 32) {
+            /* >>> Still no full stripe >>> */
+            return 0;
+        }
+
+        ringbuffer_hash_stripes(h, h->mem, 32);
+        h->memlen = 0;
+    }
+
+    /* Consume stripes directly from the input and keep the rest */
+    size_t n = ringbuffer_hash_stripes(h, data, len);
+    memcpy(h->mem, data + n, len - n);
+    h->memlen = len - n;
+
+    return 0;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_hash_update_ring(ringbuffer_hash_t* h,
+        ringbuffer_t* rb, size_t offset, size_t len) {
+
+    if (h == 0 || rb == 0) {
+        /* >>> Invalid pointer to hash state or ringbuffer >>> */
+        return -1;
+    }
+
+    ringbuffer_segments_t seg;
+    int n = ringbuffer_get_segments(rb, offset, len, &seg);
+    if (n < 0 || (size_t)n != len) {
+        /* >>> Not enough content >>> */
+        return -1;
+    }
+
+    /* Stream both linear regions into the same state */
+    ringbuffer_hash_update(h, seg.data[0], seg.len[0]);
+    ringbuffer_hash_update(h, seg.data[1], seg.len[1]);
+
+    return len;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+uint64_t ringbuffer_hash_final(const ringbuffer_hash_t* h) {
+
+    if (h == 0) {
+        return 0;
+    }
+
+    uint64_t acc;
+
+    if (h->total >= 32) {
+        acc = ringbuffer_hash_rotl(h->v[0], 1)
+                + ringbuffer_hash_rotl(h->v[1], 7)
+                + ringbuffer_hash_rotl(h->v[2], 12)
+                + ringbuffer_hash_rotl(h->v[3], 18);
+        for (int i = 0; i < 4; i++) {
+            acc = ringbuffer_hash_merge(acc, h->v[i]);
+        }
+    } else {
+        acc = h->seed + RINGBUFFER_HASH_P5;
+    }
+
+    acc += h->total;
+
+    /* Mix in the bytes that didn't make up a full stripe */
+    const uint8_t* p = h->mem;
+    size_t len = h->memlen;
+
+    for (; len >= 8; p += 8, len -= 8) {
+        acc ^= ringbuffer_hash_round(0, ringbuffer_hash_read64(p));
+        acc = ringbuffer_hash_rotl(acc, 27) * RINGBUFFER_HASH_P1
+                + RINGBUFFER_HASH_P4;
+    }
+    if (len >= 4) {
+        acc ^= (uint64_t)ringbuffer_hash_read32(p) * RINGBUFFER_HASH_P1;
+        acc = ringbuffer_hash_rotl(acc, 23) * RINGBUFFER_HASH_P2
+                + RINGBUFFER_HASH_P3;
+        p += 4;
+        len -= 4;
+    }
+    for (; len > 0; p++, len--) {
+        acc ^= *p * RINGBUFFER_HASH_P5;
+        acc = ringbuffer_hash_rotl(acc, 11) * RINGBUFFER_HASH_P1;
+    }
+
+    /* Avalanche */
+    acc ^= acc >> 33;
+    acc *= RINGBUFFER_HASH_P2;
+    acc ^= acc >> 29;
+    acc *= RINGBUFFER_HASH_P3;
+    acc ^= acc >> 32;
+
+    return acc;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_hash(ringbuffer_t* rb,
+        size_t offset, size_t len, uint64_t seed, uint64_t* hash) {
+
+    if (hash == 0) {
+        /* >>> Invalid pointer to hash result >>> */
+        return -1;
+    }
+
+    ringbuffer_hash_t h;
+    ringbuffer_hash_init(&h, seed);
+
+    int n = ringbuffer_hash_update_ring(&h, rb, offset, len);
+    if (n >= 0) {
+        *hash = ringbuffer_hash_final(&h);
+    }
+
+    return n;
+}
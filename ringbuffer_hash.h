@@ -0,0 +1,94 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+
+#ifndef RINGBUFFER_HASH_H_
+#define RINGBUFFER_HASH_H_
+
+#include "ringbuffer.h"
+
+
+/*
+ * Streaming state of a 64-bit non-cryptographic hash (XXH64). Data may be
+ * fed in pieces of any size; the result only depends on the concatenation.
+ */
+typedef struct {
+
+    /* the four accumulator lanes */
+    uint64_t v[4];
+
+    /* total number of bytes fed so far */
+    uint64_t total;
+
+    /* the seed the state was initialised with */
+    uint64_t seed;
+
+    /* bytes not yet consumed by a full 32-byte stripe */
+    uint8_t mem[32];
+    size_t memlen;
+
+} ringbuffer_hash_t;
+
+
+/* ========================================================================= */
+
+/*
+ * Initialises hash state <h> with <seed>.
+ */
+int ringbuffer_hash_init(ringbuffer_hash_t* h, uint64_t seed);
+
+
+/*
+ * Feeds <len> bytes at <data> into hash state <h>.
+ */
+int ringbuffer_hash_update(
+        ringbuffer_hash_t* h, const uint8_t* data, size_t len);
+
+
+/*
+ * Feeds <len> bytes of content of <rb> starting at <offset> into hash state
+ * <h> in place. Returns the number of bytes fed, or -1 if there is less
+ * content.
+ */
+int ringbuffer_hash_update_ring(ringbuffer_hash_t* h,
+        ringbuffer_t* rb, size_t offset, size_t len);
+
+
+/*
+ * Returns the hash of all data fed into <h> so far (<h> is not modified).
+ */
+uint64_t ringbuffer_hash_final(const ringbuffer_hash_t* h);
+
+
+/*
+ * Computes the hash of <len> bytes of content of <rb> starting at <offset>
+ * with <seed> and stores it in <hash>. Returns the number of bytes hashed,
+ * or -1 if there is less content.
+ */
+int ringbuffer_hash(ringbuffer_t* rb,
+        size_t offset, size_t len, uint64_t seed, uint64_t* hash);
+
+#endif
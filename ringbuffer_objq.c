@@ -0,0 +1,170 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "ringbuffer_objq.h"
+#include <string.h>
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_objq_init(ringbuffer_objq_t* q, uint8_t* mem, size_t memlen,
+        size_t esize, ringbuffer_objq_move_t move,
+        ringbuffer_objq_dtor_t dtor) {
+
+    /* Sanity check: make sure input pointers are ok */
+    if (q == 0 || mem == 0 || esize == 0) {
+        /* >>> Invalid pointer(s) or object size >>> */
+        return -1;
+    }
+
+    q->esize = esize;
+    q->move = move;
+    q->dtor = dtor;
+
+    /* Only use a multiple of the object size such that slots never wrap */
+    if (ringbuffer_init(&q->rb, mem, (memlen / esize) * esize) < 0) {
+        return -1;
+    }
+
+    return memlen / esize;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_objq_get_length(ringbuffer_objq_t* q) {
+
+    if (q == 0) {
+        return -1;
+    }
+
+    return q->rb.len / q->esize;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+void* ringbuffer_objq_emplace(ringbuffer_objq_t* q) {
+
+    if (q == 0 || q->rb.len + q->esize > q->rb.size) {
+        /* >>> Invalid pointer to queue or queue is full >>> */
+        return 0;
+    }
+
+    /* The new slot starts at the write index and is linear */
+    uint8_t* obj = q->rb.buffer + q->rb.iw;
+
+    /* Advance write index */
+    q->rb.iw += q->esize;
+    if (q->rb.iw == q->rb.size) {
+        /* Wrap write index */
+        q->rb.iw = 0;
+    }
+    q->rb.len += q->esize;
+    q->rb.written += q->esize;
+
+    return obj;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+void* ringbuffer_objq_front(ringbuffer_objq_t* q) {
+
+    if (q == 0 || q->rb.len == 0) {
+        /* >>> Invalid pointer to queue or queue is empty >>> */
+        return 0;
+    }
+
+    return q->rb.buffer + q->rb.ir;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_objq_pop(ringbuffer_objq_t* q, void* obj) {
+
+    void* front = ringbuffer_objq_front(q);
+
+    if (front == 0 || obj == 0) {
+        return 0;
+    }
+
+    if (q->move != 0) {
+        /* Move object out and destroy what's left behind */
+        q->move(obj, front);
+        if (q->dtor != 0) {
+            q->dtor(front);
+        }
+    } else {
+        /* Relocate object bitwise (no destructor call; the caller owns
+         * it now) */
+        memcpy(obj, front, q->esize);
+    }
+
+    return ringbuffer_discard(&q->rb, q->esize);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_objq_discard(ringbuffer_objq_t* q, size_t n) {
+
+    if (q == 0) {
+        return -1;
+    }
+
+    size_t i;
+    for (i = 0; i < n && q->rb.len > 0; i++) {
+
+        if (q->dtor != 0) {
+            q->dtor(q->rb.buffer + q->rb.ir);
+        }
+
+        ringbuffer_discard(&q->rb, q->esize);
+    }
+
+    return i;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_objq_clear(ringbuffer_objq_t* q) {
+
+    if (q == 0) {
+        return -1;
+    }
+
+    return ringbuffer_objq_discard(q, q->rb.len / q->esize);
+}
@@ -0,0 +1,124 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef RINGBUFFER_OBJQ_H_
+#define RINGBUFFER_OBJQ_H_
+
+#include "ringbuffer.h"
+
+
+/*
+ * Function releasing resources held by an object (called on discard/clear)
+ */
+typedef void (*ringbuffer_objq_dtor_t)(void* obj);
+
+
+/*
+ * Function moving an object from <src> to (uninitialized) <dst>, leaving
+ * <src> in a destructible state (called on pop)
+ */
+typedef void (*ringbuffer_objq_move_t)(void* dst, void* src);
+
+
+/*
+ * A queue of fixed-size objects stored in place in a ringbuffer. Slots never
+ * wrap around the end of the buffer, so objects can be initialized and used
+ * directly in ringbuffer memory. Objects are aligned in the buffer if the
+ * memory and the object size are.
+ */
+typedef struct {
+
+    /* the underlying ringbuffer */
+    ringbuffer_t rb;
+
+    /* size of an object */
+    size_t esize;
+
+    /* object move function (0 means bitwise move) */
+    ringbuffer_objq_move_t move;
+
+    /* object destructor (may be 0) */
+    ringbuffer_objq_dtor_t dtor;
+
+} ringbuffer_objq_t;
+
+
+/* ========================================================================= */
+
+/*
+ * Sets up a queue of <esize>-byte objects in <memlen> bytes at <mem>.
+ * <move> moves an object out of the queue on pop (may be 0 for objects that
+ * may be relocated bitwise, i.e. that hold no pointers into themselves and
+ * are not registered by address anywhere). <dtor> is called for every object
+ * discarded from the queue and for the moved-from object on pop (may be 0).
+ * Returns the number of objects the queue can hold.
+ */
+int ringbuffer_objq_init(ringbuffer_objq_t* q, uint8_t* mem, size_t memlen,
+        size_t esize, ringbuffer_objq_move_t move, ringbuffer_objq_dtor_t dtor);
+
+
+/*
+ * Returns the number of objects in the queue.
+ */
+int ringbuffer_objq_get_length(ringbuffer_objq_t* q);
+
+
+/*
+ * Appends a new object to the queue and returns a pointer to its (uninitial-
+ * ized) slot for in-place construction, or 0 if the queue is full.
+ */
+void* ringbuffer_objq_emplace(ringbuffer_objq_t* q);
+
+
+/*
+ * Returns a pointer to the oldest object in the queue, or 0 if it is empty.
+ */
+void* ringbuffer_objq_front(ringbuffer_objq_t* q);
+
+
+/*
+ * Moves the oldest object out of the queue into (uninitialized) <obj> and
+ * removes it. With a move function, the moved-from object is destroyed in
+ * the queue afterwards; without one, the object is copied bitwise and
+ * ownership passes to the caller, so the destructor is not called. Returns
+ * the object size, or 0 if the queue is empty.
+ */
+int ringbuffer_objq_pop(ringbuffer_objq_t* q, void* obj);
+
+
+/*
+ * Destroys and removes up to <n> of the oldest objects. Returns the number
+ * of objects removed.
+ */
+int ringbuffer_objq_discard(ringbuffer_objq_t* q, size_t n);
+
+
+/*
+ * Destroys and removes all objects. Returns the number of objects removed.
+ */
+int ringbuffer_objq_clear(ringbuffer_objq_t* q);
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+
+#ifndef RINGBUFFER_PARALLEL_H_
+#define RINGBUFFER_PARALLEL_H_
+
+#include "ringbuffer.h"
+
+
+/* Maximum number of chunks content is split into */
+#ifndef RINGBUFFER_PARALLEL_MAX_CHUNKS
+#define RINGBUFFER_PARALLEL_MAX_CHUNKS 64
+#endif
+
+
+/*
+ * A task to run once per chunk: <arg> is opaque, <index> is the chunk index
+ */
+typedef void (*ringbuffer_task_t)(void* arg, size_t index);
+
+
+/*
+ * A caller-supplied runner: runs <task>(<arg>, i) for every i in
+ * [0, <ntasks>), in any order and on any threads, and returns once all tasks
+ * have completed (or a negative value if they could not be run). <pool> is
+ * passed through unchanged, e.g. to identify the caller's thread pool.
+ */
+typedef int (*ringbuffer_runner_t)(void* pool,
+        ringbuffer_task_t task, void* arg, size_t ntasks);
+
+
+/* ========================================================================= */
+
+/*
+ * Same as ringbuffer_find(), but splits the search into <nchunks> chunks
+ * (overlapping by <len> - 1 bytes) run by <runner> on <pool>. Returns the
+ * offset of the earliest match, or -1 if there is none. If <runner> is 0,
+ * chunks are searched on the calling thread.
+ */
+int ringbuffer_find_parallel(ringbuffer_t* rb, size_t offset,
+        const uint8_t* data, size_t len, size_t nchunks,
+        ringbuffer_runner_t runner, void* pool);
+
+
+/*
+ * Continues CRC-32 (IEEE 802.3) <crc> over <len> bytes at <data>. Start
+ * with <crc> = 0.
+ */
+uint32_t ringbuffer_crc32_update(
+        uint32_t crc, const uint8_t* data, size_t len);
+
+
+/*
+ * Returns the CRC-32 of the concatenation of two blocks given their CRC-32
+ * values <crc1> and <crc2> and the length <len2> of the second block.
+ */
+uint32_t ringbuffer_crc32_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+
+
+/*
+ * Computes the CRC-32 of <len> bytes of content starting at <offset> in
+ * place and stores it in <crc>. Returns the number of bytes covered, or -1
+ * if there is less content.
+ */
+int ringbuffer_crc32(ringbuffer_t* rb,
+        size_t offset, size_t len, uint32_t* crc);
+
+
+/*
+ * Same as ringbuffer_crc32(), but splits the content into <nchunks> chunks
+ * run by <runner> on <pool> and combines their CRC-32 values.
+ */
+int ringbuffer_crc32_parallel(ringbuffer_t* rb, size_t offset, size_t len,
+        uint32_t* crc, size_t nchunks, ringbuffer_runner_t runner, void* pool);
+
+#endif
@@ -0,0 +1,212 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "ringbuffer_pipeline.h"
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static size_t ringbuffer_pipeline_barrier(
+        ringbuffer_pipeline_t* pl, size_t stage) {
+
+    /* Stage 0 depends on the producer, any other stage on its predecessor */
+    return (stage == 0) ? pl->rb->len : pl->cursors[stage - 1];
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_pipeline_init(ringbuffer_pipeline_t* pl,
+        ringbuffer_t* rb, size_t* cursors, size_t nstages) {
+
+    /* Sanity check: make sure input pointers are ok */
+    if (pl == 0 || rb == 0 || cursors == 0 || nstages == 0) {
+        /* >>> Invalid pointer(s) or no stages >>> */
+        return -1;
+    }
+
+    pl->rb = rb;
+    pl->cursors = cursors;
+    pl->nstages = nstages;
+
+    /* No stage has processed anything yet */
+    for (size_t i = 0; i < nstages; i++) {
+        cursors[i] = 0;
+    }
+
+    return nstages;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_pipeline_get_length(ringbuffer_pipeline_t* pl, size_t stage) {
+
+    if (pl == 0 || stage >= pl->nstages) {
+        /* >>> Invalid pointer to pipeline or invalid stage >>> */
+        return -1;
+    }
+
+    return ringbuffer_pipeline_barrier(pl, stage) - pl->cursors[stage];
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_pipeline_get_segments(ringbuffer_pipeline_t* pl,
+        size_t stage, ringbuffer_segments_t* seg) {
+
+    if (pl == 0 || stage >= pl->nstages) {
+        /* >>> Invalid pointer to pipeline or invalid stage >>> */
+        return -1;
+    }
+
+    return ringbuffer_get_segments(pl->rb, pl->cursors[stage],
+            ringbuffer_pipeline_barrier(pl, stage) - pl->cursors[stage], seg);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_pipeline_advance(
+        ringbuffer_pipeline_t* pl, size_t stage, size_t len) {
+
+    if (pl == 0 || stage >= pl->nstages) {
+        /* >>> Invalid pointer to pipeline or invalid stage >>> */
+        return -1;
+    }
+
+    /* don't release more than the upstream stage has released */
+    size_t avail = ringbuffer_pipeline_barrier(pl, stage) - pl->cursors[stage];
+    if (len > avail) {
+        len = avail;
+    }
+
+    pl->cursors[stage] += len;
+
+    if (stage == pl->nstages - 1) {
+        /* >>> Last stage: reclaim space in the ringbuffer >>> */
+
+        size_t done = pl->cursors[stage];
+        ringbuffer_discard(pl->rb, done);
+
+        /* Cursors are relative to the read index which just moved */
+        for (size_t i = 0; i < pl->nstages; i++) {
+            pl->cursors[i] -= done;
+        }
+    }
+
+    return len;
+}
+
+
+/*
+ * Reads the length of the next block available to stage <stage> into <bl>.
+ * Returns 1 if there is a complete block, 0 if there is none, or -1 if the
+ * block is inconsistent.
+ * ___________________________________________________________________________
+ */
+static int ringbuffer_pipeline_next_block(
+        ringbuffer_pipeline_t* pl, size_t stage, size_t* bl) {
+
+    if (pl == 0 || stage >= pl->nstages) {
+        return 0;
+    }
+
+    size_t avail = ringbuffer_pipeline_barrier(pl, stage) - pl->cursors[stage];
+
+    /* Read the block length */
+    if (avail < sizeof(size_t) || ringbuffer_peek_offset(pl->rb,
+            pl->cursors[stage], (uint8_t*)bl, sizeof(size_t))
+                    != sizeof(size_t)) {
+        /* >>> No block available to this stage >>> */
+        return 0;
+    }
+
+    /* Sanity check: make sure the block has been fully released upstream */
+    if (*bl + sizeof(size_t) > avail) {
+        /* >>> Invalid block >>> */
+        return -1;
+    }
+
+    return 1;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_pipeline_peek_block_length(
+        ringbuffer_pipeline_t* pl, size_t stage) {
+
+    size_t bl = 0;
+    int res = ringbuffer_pipeline_next_block(pl, stage, &bl);
+
+    return (res > 0) ? (int)bl : res;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_pipeline_get_block(ringbuffer_pipeline_t* pl,
+        size_t stage, ringbuffer_segments_t* seg) {
+
+    /* Read the block length with sanity checks */
+    int bl = ringbuffer_pipeline_peek_block_length(pl, stage);
+
+    if (bl <= 0 || seg == 0) {
+        /* >>> Invalid or empty block >>> */
+        return 0;
+    }
+
+    return ringbuffer_get_segments(pl->rb,
+            pl->cursors[stage] + sizeof(size_t), bl, seg);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_pipeline_advance_block(ringbuffer_pipeline_t* pl, size_t stage) {
+
+    /* Read the block length with sanity checks (a block may be empty, so
+     * its presence is told apart from its length) */
+    size_t bl = 0;
+    int res = ringbuffer_pipeline_next_block(pl, stage, &bl);
+
+    if (res <= 0) {
+        /* >>> No block or invalid block >>> */
+        return res;
+    }
+
+    return ringbuffer_pipeline_advance(pl, stage, bl + sizeof(size_t));
+}
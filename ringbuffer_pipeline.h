@@ -0,0 +1,121 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef RINGBUFFER_PIPELINE_H_
+#define RINGBUFFER_PIPELINE_H_
+
+#include "ringbuffer.h"
+
+
+/*
+ * A pipeline of consumer stages sharing a single ringbuffer. Data is written
+ * to the ringbuffer as usual; stage 0 processes it first, stage i only sees
+ * data already processed by stage i-1, and the ringbuffer's space is only
+ * reclaimed once the last stage has processed it. Stages access content in
+ * place, so no data is copied between stages.
+ *
+ * The pipeline is not thread-safe: cursors are plain offsets relative to the
+ * read index, and the last stage rebases all of them when it reclaims space.
+ * Calls for different stages (and the producer's writes) must be serialized
+ * by the caller, e.g. by running all stages from one thread or under a lock.
+ */
+typedef struct {
+
+    /* the ringbuffer shared by all stages */
+    ringbuffer_t* rb;
+
+    /* per-stage cursors (offsets relative to the read index) */
+    size_t* cursors;
+
+    /* number of stages */
+    size_t nstages;
+
+} ringbuffer_pipeline_t;
+
+
+/* ========================================================================= */
+
+/*
+ * Sets up a pipeline of <nstages> stages on ringbuffer <rb> using the
+ * caller-provided array <cursors> (<nstages> elements) for stage cursors.
+ */
+int ringbuffer_pipeline_init(ringbuffer_pipeline_t* pl,
+        ringbuffer_t* rb, size_t* cursors, size_t nstages);
+
+
+/*
+ * Returns the number of bytes stage <stage> may process, i.e. the bytes
+ * already released by the upstream stage (or the producer for stage 0).
+ */
+int ringbuffer_pipeline_get_length(ringbuffer_pipeline_t* pl, size_t stage);
+
+
+/*
+ * Describes the bytes available to stage <stage> as (at most) two linear
+ * regions for in-place processing. Returns the total length described.
+ */
+int ringbuffer_pipeline_get_segments(ringbuffer_pipeline_t* pl,
+        size_t stage, ringbuffer_segments_t* seg);
+
+
+/*
+ * Marks <len> bytes as processed by stage <stage>, releasing them to the
+ * downstream stage. If <stage> is the last stage, the bytes are discarded
+ * from the ringbuffer. Returns the number of bytes released.
+ */
+int ringbuffer_pipeline_advance(
+        ringbuffer_pipeline_t* pl, size_t stage, size_t len);
+
+
+/* ========================================================================= */
+/* Block access                                                              */
+/* ========================================================================= */
+
+/*
+ * Returns the payload length of the next block available to stage <stage>
+ * (0 if there is none or it is empty, -1 if the block is inconsistent).
+ */
+int ringbuffer_pipeline_peek_block_length(
+        ringbuffer_pipeline_t* pl, size_t stage);
+
+
+/*
+ * Describes the payload of the next block available to stage <stage> as
+ * (at most) two linear regions. Returns the payload length (0 if none).
+ */
+int ringbuffer_pipeline_get_block(ringbuffer_pipeline_t* pl,
+        size_t stage, ringbuffer_segments_t* seg);
+
+
+/*
+ * Releases the next block available to stage <stage> to the downstream stage
+ * (or discards it in case of the last stage). Returns the number of bytes
+ * released including the block header, so empty blocks are released, too
+ * (0 if there is no block, -1 if the block is inconsistent).
+ */
+int ringbuffer_pipeline_advance_block(ringbuffer_pipeline_t* pl, size_t stage);
+
+#endif
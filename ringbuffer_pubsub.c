@@ -0,0 +1,301 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+
+#include "ringbuffer_pubsub.h"
+#include <string.h>
+
+
+/*
+ * Discards content all subscribers have read and rebases their cursors.
+ * ___________________________________________________________________________
+ */
+static void ringbuffer_topic_reclaim(ringbuffer_topic_t* t) {
+
+    /* The slowest subscriber determines what may go (everything if there
+     * are no subscribers) */
+    size_t done = t->rb->len;
+    for (size_t i = 0; i < t->nslots; i++) {
+        if (t->cursors[i] != RINGBUFFER_TOPIC_FREE && t->cursors[i] < done) {
+            done = t->cursors[i];
+        }
+    }
+
+    if (done == 0) {
+        return;
+    }
+
+    ringbuffer_discard(t->rb, done);
+
+    /* Cursors are relative to the read index which just moved */
+    for (size_t i = 0; i < t->nslots; i++) {
+        if (t->cursors[i] != RINGBUFFER_TOPIC_FREE) {
+            t->cursors[i] -= done;
+        }
+    }
+}
+
+
+/*
+ * Returns the length of the next message for subscriber <id> (-1 if none).
+ * ___________________________________________________________________________
+ */
+static int ringbuffer_topic_peek_length(ringbuffer_topic_t* t, size_t id) {
+
+    if (t == 0 || id >= t->nslots || t->cursors[id] == RINGBUFFER_TOPIC_FREE) {
+        /* >>> Invalid pointer to topic or invalid subscriber >>> */
+        return -1;
+    }
+
+    /* Read the block length */
+    size_t bl = 0;
+    if (ringbuffer_peek_offset(t->rb, t->cursors[id],
+            (uint8_t*)&bl, sizeof(size_t)) != sizeof(size_t)) {
+        /* >>> No message pending >>> */
+        return -1;
+    }
+
+    /* Sanity check: make sure the block is complete */
+    if (bl + sizeof(size_t) > t->rb->len - t->cursors[id]) {
+        /* >>> Invalid block >>> */
+        return -1;
+    }
+
+    return bl;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_topic_init(ringbuffer_topic_t* t,
+        ringbuffer_t* rb, size_t* cursors, size_t nslots) {
+
+    /* Sanity check: make sure input pointers are ok */
+    if (t == 0 || rb == 0 || (cursors == 0 && nslots > 0)) {
+        /* >>> Invalid pointer(s) >>> */
+        return -1;
+    }
+
+    t->rb = rb;
+    t->cursors = cursors;
+    t->nslots = nslots;
+
+    /* No subscribers yet */
+    for (size_t i = 0; i < nslots; i++) {
+        cursors[i] = RINGBUFFER_TOPIC_FREE;
+    }
+
+    return nslots;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_topic_subscribe(ringbuffer_topic_t* t, int from) {
+
+    if (t == 0) {
+        /* >>> Invalid pointer to topic >>> */
+        return -1;
+    }
+
+    for (size_t i = 0; i < t->nslots; i++) {
+        if (t->cursors[i] == RINGBUFFER_TOPIC_FREE) {
+            /* >>> Found a free slot >>> */
+            t->cursors[i] = (from == RINGBUFFER_TOPIC_TAIL) ? t->rb->len : 0;
+            return i;
+        }
+    }
+
+    /* >>> All slots taken >>> */
+    return -1;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_topic_unsubscribe(ringbuffer_topic_t* t, size_t id) {
+
+    if (t == 0 || id >= t->nslots || t->cursors[id] == RINGBUFFER_TOPIC_FREE) {
+        /* >>> Invalid pointer to topic or invalid subscriber >>> */
+        return -1;
+    }
+
+    t->cursors[id] = RINGBUFFER_TOPIC_FREE;
+    ringbuffer_topic_reclaim(t);
+
+    return 0;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_topic_publish(
+        ringbuffer_topic_t* t, const uint8_t* data, size_t len) {
+
+    if (t == 0) {
+        /* >>> Invalid pointer to topic >>> */
+        return -1;
+    }
+
+    /* Write the message once for all subscribers */
+    int n = ringbuffer_write_block(t->rb, data, len);
+    if (n <= 0) {
+        /* >>> Not enough space (or invalid data pointer) >>> */
+        return -1;
+    }
+
+    /* Drop the message right away if nobody is listening */
+    ringbuffer_topic_reclaim(t);
+
+    return n;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_topic_receive(
+        ringbuffer_topic_t* t, size_t id, ringbuffer_segments_t* seg) {
+
+    int bl = ringbuffer_topic_peek_length(t, id);
+
+    if (bl < 0 || seg == 0) {
+        /* >>> No message pending or invalid segment descriptor >>> */
+        return -1;
+    }
+
+    return ringbuffer_get_segments(t->rb,
+            t->cursors[id] + sizeof(size_t), bl, seg);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_topic_release(ringbuffer_topic_t* t, size_t id) {
+
+    int bl = ringbuffer_topic_peek_length(t, id);
+
+    if (bl < 0) {
+        /* >>> No message pending >>> */
+        return -1;
+    }
+
+    /* Reclaiming is only needed if this subscriber was (one of) the
+     * slowest, i.e. at the read index */
+    int slowest = (t->cursors[id] == 0);
+
+    t->cursors[id] += sizeof(size_t) + bl;
+
+    if (slowest) {
+        ringbuffer_topic_reclaim(t);
+    }
+
+    return bl;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_topic_get_pending(ringbuffer_topic_t* t, size_t id) {
+
+    if (t == 0 || id >= t->nslots || t->cursors[id] == RINGBUFFER_TOPIC_FREE) {
+        /* >>> Invalid pointer to topic or invalid subscriber >>> */
+        return -1;
+    }
+
+    return t->rb->len - t->cursors[id];
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_broker_init(ringbuffer_broker_t* b,
+        ringbuffer_topic_t* topics, const char** names, size_t max) {
+
+    /* Sanity check: make sure input pointers are ok */
+    if (b == 0 || ((topics == 0 || names == 0) && max > 0)) {
+        /* >>> Invalid pointer(s) >>> */
+        return -1;
+    }
+
+    b->topics = topics;
+    b->names = names;
+    b->ntopics = 0;
+    b->max = max;
+
+    return max;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+ringbuffer_topic_t* ringbuffer_broker_add(ringbuffer_broker_t* b,
+        const char* name, ringbuffer_t* rb, size_t* cursors, size_t nslots) {
+
+    if (b == 0 || name == 0 || b->ntopics == b->max
+            || ringbuffer_broker_find(b, name) != 0) {
+        /* >>> Invalid pointer(s), no room, or name taken >>> */
+        return 0;
+    }
+
+    ringbuffer_topic_t* t = &b->topics[b->ntopics];
+    if (ringbuffer_topic_init(t, rb, cursors, nslots) < 0) {
+        /* >>> Invalid topic parameters >>> */
+        return 0;
+    }
+
+    b->names[b->ntopics++] = name;
+
+    return t;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+ringbuffer_topic_t* ringbuffer_broker_find(
+        ringbuffer_broker_t* b, const char* name) {
+
+    if (b == 0 || name == 0) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < b->ntopics; i++) {
+        if (strcmp(b->names[i], name) == 0) {
+            return &b->topics[i];
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,159 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+
+#ifndef RINGBUFFER_PUBSUB_H_
+#define RINGBUFFER_PUBSUB_H_
+
+#include "ringbuffer.h"
+
+
+/* Where a new subscriber starts reading */
+#define RINGBUFFER_TOPIC_HEAD   0   /* oldest message still retained */
+#define RINGBUFFER_TOPIC_TAIL   1   /* next message published */
+
+/* Cursor value marking an unused subscriber slot */
+#define RINGBUFFER_TOPIC_FREE   ((size_t)-1)
+
+
+/*
+ * A topic: messages are published once as blocks into a ringbuffer and read
+ * in place by any number of subscribers, each with its own cursor. Space is
+ * reclaimed once the slowest subscriber has read a message (or right away if
+ * there are no subscribers).
+ */
+typedef struct {
+
+    /* the ringbuffer backing the topic */
+    ringbuffer_t* rb;
+
+    /* per-subscriber cursors (offsets relative to the read index) */
+    size_t* cursors;
+
+    /* number of subscriber slots */
+    size_t nslots;
+
+} ringbuffer_topic_t;
+
+
+/*
+ * A broker: a registry of named topics
+ */
+typedef struct {
+
+    /* topics and their names (caller-provided arrays) */
+    ringbuffer_topic_t* topics;
+    const char** names;
+
+    /* number of topics registered and maximum number of topics */
+    size_t ntopics;
+    size_t max;
+
+} ringbuffer_broker_t;
+
+
+/* ========================================================================= */
+
+/*
+ * Sets up topic <t> on ringbuffer <rb> with <nslots> subscriber slots using
+ * the caller-provided array <cursors> (<nslots> elements).
+ */
+int ringbuffer_topic_init(ringbuffer_topic_t* t,
+        ringbuffer_t* rb, size_t* cursors, size_t nslots);
+
+
+/*
+ * Adds a subscriber starting at RINGBUFFER_TOPIC_HEAD or RINGBUFFER_TOPIC_TAIL
+ * (<from>). Returns the subscriber's id, or -1 if all slots are taken.
+ */
+int ringbuffer_topic_subscribe(ringbuffer_topic_t* t, int from);
+
+
+/*
+ * Removes subscriber <id> and reclaims space it was holding back.
+ */
+int ringbuffer_topic_unsubscribe(ringbuffer_topic_t* t, size_t id);
+
+
+/*
+ * Publishes a message of <len> bytes to all subscribers. Returns the number
+ * of bytes written including the block header, or -1 if there is not enough
+ * space (i.e. the slowest subscriber is too far behind).
+ */
+int ringbuffer_topic_publish(
+        ringbuffer_topic_t* t, const uint8_t* data, size_t len);
+
+
+/*
+ * Describes the next message for subscriber <id> as (at most) two linear
+ * regions for in-place access. Returns the message length, or -1 if there
+ * is no message pending.
+ */
+int ringbuffer_topic_receive(
+        ringbuffer_topic_t* t, size_t id, ringbuffer_segments_t* seg);
+
+
+/*
+ * Marks the next message as read by subscriber <id>, reclaiming its space
+ * once all subscribers have read it. Returns the message length, or -1 if
+ * there is no message pending.
+ */
+int ringbuffer_topic_release(ringbuffer_topic_t* t, size_t id);
+
+
+/*
+ * Returns the number of bytes (including block headers) pending for
+ * subscriber <id>.
+ */
+int ringbuffer_topic_get_pending(ringbuffer_topic_t* t, size_t id);
+
+
+/* ========================================================================= */
+
+/*
+ * Sets up broker <b> with room for <max> topics using the caller-provided
+ * arrays <topics> and <names> (<max> elements each).
+ */
+int ringbuffer_broker_init(ringbuffer_broker_t* b,
+        ringbuffer_topic_t* topics, const char** names, size_t max);
+
+
+/*
+ * Registers a topic named <name> (the string must outlive the broker) on
+ * ringbuffer <rb>, see ringbuffer_topic_init(). Returns the topic, or 0 if
+ * the name is taken or there is no room.
+ */
+ringbuffer_topic_t* ringbuffer_broker_add(ringbuffer_broker_t* b,
+        const char* name, ringbuffer_t* rb, size_t* cursors, size_t nslots);
+
+
+/*
+ * Returns the topic named <name>, or 0 if there is none.
+ */
+ringbuffer_topic_t* ringbuffer_broker_find(
+        ringbuffer_broker_t* b, const char* name);
+
+#endif
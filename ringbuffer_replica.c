@@ -0,0 +1,195 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+
+#include "ringbuffer_replica.h"
+#include <string.h>
+
+
+/*
+ * Publishes reading index <ir> and length <len> to the mirror.
+ * ___________________________________________________________________________
+ */
+static void ringbuffer_replica_publish(
+        ringbuffer_replica_t* r, size_t ir, size_t len) {
+
+    ringbuffer_mirror_t* m = r->mirror;
+
+    /* Fill the slot not currently selected, then switch slots. The release
+     * store also publishes the buffer content copied before. */
+    uint64_t seq = __atomic_load_n(&m->seq, __ATOMIC_RELAXED) + 1;
+    __atomic_store_n(&m->ir[seq & 1], (uint64_t)ir, __ATOMIC_RELAXED);
+    __atomic_store_n(&m->len[seq & 1], (uint64_t)len, __ATOMIC_RELAXED);
+    __atomic_store_n(&m->seq, seq, __ATOMIC_RELEASE);
+}
+
+
+/*
+ * Copies the primary's content from <offset> to its end into the mirror.
+ * ___________________________________________________________________________
+ */
+static size_t ringbuffer_replica_copy(ringbuffer_replica_t* r, size_t offset) {
+
+    ringbuffer_segments_t seg;
+    size_t n = ringbuffer_get_segments(r->rb, offset, r->rb->len, &seg);
+
+    /* Deltas go to the same offsets in the mirror's buffer */
+    for (int i = 0; i < 2; i++) {
+        memcpy(r->mirror->data + (seg.data[i] - r->rb->buffer),
+                seg.data[i], seg.len[i]);
+    }
+
+    return n;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_replica_init(ringbuffer_replica_t* r,
+        ringbuffer_t* rb, ringbuffer_mirror_t* mirror) {
+
+    /* Sanity check: make sure input pointers are ok */
+    if (r == 0 || rb == 0 || mirror == 0) {
+        /* >>> Invalid pointer(s) >>> */
+        return -1;
+    }
+
+    r->rb = rb;
+    r->mirror = mirror;
+
+    /* Start with an empty mirror, then copy everything */
+    mirror->seq = 0;
+    mirror->size = rb->size;
+    mirror->ir[0] = rb->ir;
+    mirror->len[0] = 0;
+
+    size_t n = ringbuffer_replica_copy(r, 0);
+    ringbuffer_replica_publish(r, rb->ir, rb->len);
+
+    r->written = rb->written;
+    r->len = rb->len;
+
+    return n;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_replica_commit(ringbuffer_replica_t* r) {
+
+    if (r == 0) {
+        /* >>> Invalid pointer to replica >>> */
+        return -1;
+    }
+
+    ringbuffer_t* rb = r->rb;
+
+    /* Bytes written since the last commit (exact, unlike the difference
+     * of writing indices which is taken modulo size) and hence bytes read */
+    size_t written = rb->written - r->written;
+    size_t consumed = r->len + written - rb->len;
+
+    /* Offset of the first byte not mirrored yet */
+    size_t offset;
+
+    if (written >= rb->size || consumed >= r->len) {
+        /* >>> All previously mirrored content is gone (possibly overrun
+         * by a buffer's worth of writes or more): copy everything >>> */
+        ringbuffer_replica_publish(r, rb->ir, 0);
+        offset = 0;
+    } else {
+        /* >>> Drop consumed content first, so the remaining content
+         * doesn't overlap with space about to be overwritten >>> */
+        offset = r->len - consumed;
+        if (consumed > 0) {
+            ringbuffer_replica_publish(r, rb->ir, offset);
+        }
+    }
+
+    size_t n = 0;
+    if (offset < rb->len) {
+        n = ringbuffer_replica_copy(r, offset);
+        ringbuffer_replica_publish(r, rb->ir, rb->len);
+    }
+
+    r->written = rb->written;
+    r->len = rb->len;
+
+    return n;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_mirror_get_state(
+        ringbuffer_mirror_t* mirror, size_t* ir, size_t* len) {
+
+    if (mirror == 0 || ir == 0 || len == 0) {
+        /* >>> Invalid pointer(s) >>> */
+        return -1;
+    }
+
+    uint64_t seq;
+
+    /* Retry if the slot read was reused by a commit meanwhile */
+    do {
+        seq = __atomic_load_n(&mirror->seq, __ATOMIC_ACQUIRE);
+        *ir = __atomic_load_n(&mirror->ir[seq & 1], __ATOMIC_RELAXED);
+        *len = __atomic_load_n(&mirror->len[seq & 1], __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&mirror->seq, __ATOMIC_RELAXED) != seq);
+
+    return *len;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_replica_attach(ringbuffer_t* rb, ringbuffer_mirror_t* mirror) {
+
+    if (rb == 0 || mirror == 0 || mirror->size == 0) {
+        /* >>> Invalid pointer(s) or uninitialised mirror >>> */
+        return -1;
+    }
+
+    size_t ir;
+    size_t len;
+    ringbuffer_mirror_get_state(mirror, &ir, &len);
+
+    rb->buffer = mirror->data;
+    rb->size = mirror->size;
+    rb->ir = ir;
+    rb->len = len;
+    rb->iw = (ir + len) % rb->size;
+    rb->written = 0;
+    rb->stream_threshold = RINGBUFFER_STREAM_THRESHOLD;
+
+    return len;
+}
@@ -0,0 +1,121 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+
+#ifndef RINGBUFFER_REPLICA_H_
+#define RINGBUFFER_REPLICA_H_
+
+#include "ringbuffer.h"
+
+
+/*
+ * A mirror of a ringbuffer, meant to be placed in shared memory so a standby
+ * process can take over the content of a primary's ringbuffer. Fields have
+ * fixed widths so processes of different word size may share a mirror.
+ */
+typedef struct {
+
+    /* number of commits; its lowest bit selects the current index slot */
+    uint64_t seq;
+
+    /* size of buffer */
+    uint64_t size;
+
+    /* two slots of reading index and length of content (the one not
+     * selected by <seq> is the one being updated) */
+    uint64_t ir[2];
+    uint64_t len[2];
+
+    /* copy of the primary's buffer */
+    uint8_t data[];
+
+} ringbuffer_mirror_t;
+
+
+/*
+ * Number of bytes to allocate for a mirror of a ringbuffer of <capacity> bytes
+ */
+#define RINGBUFFER_MIRROR_SIZEOF(capacity) \
+    (sizeof(ringbuffer_mirror_t) + (capacity))
+
+
+/*
+ * The primary's side of replicating a ringbuffer into a mirror
+ */
+typedef struct {
+
+    /* the primary ringbuffer */
+    ringbuffer_t* rb;
+
+    /* the mirror */
+    ringbuffer_mirror_t* mirror;
+
+    /* the primary's write count and length as of the last commit */
+    size_t written;
+    size_t len;
+
+} ringbuffer_replica_t;
+
+
+/* ========================================================================= */
+
+/*
+ * Sets up replication of ringbuffer <rb> into <mirror> (which must provide
+ * room for RINGBUFFER_MIRROR_SIZEOF(<rb>->size) bytes) and copies the
+ * current content.
+ */
+int ringbuffer_replica_init(ringbuffer_replica_t* r,
+        ringbuffer_t* rb, ringbuffer_mirror_t* mirror);
+
+
+/*
+ * Brings the mirror up to date: copies only the bytes written since the last
+ * commit (to the same offsets in the mirror's buffer) and then publishes the
+ * primary's indices. Content visible in the mirror is consistent at any time,
+ * even if the primary dies during a commit. If all content mirrored before
+ * has been consumed meanwhile (e.g. because the primary overran the mirror
+ * by writing a buffer's worth of bytes or more), the whole content is copied.
+ * Returns the number of bytes copied.
+ */
+int ringbuffer_replica_commit(ringbuffer_replica_t* r);
+
+
+/*
+ * Reads a consistent pair of reading index and content length (as of the
+ * last commit) from <mirror>.
+ */
+int ringbuffer_mirror_get_state(
+        ringbuffer_mirror_t* mirror, size_t* ir, size_t* len);
+
+
+/*
+ * Takes over the content of <mirror> (as of the last commit): sets up <rb>
+ * to operate on the mirror's buffer in place. The primary must no longer
+ * commit to the mirror afterwards.
+ */
+int ringbuffer_replica_attach(ringbuffer_t* rb, ringbuffer_mirror_t* mirror);
+
+#endif
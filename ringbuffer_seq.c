@@ -0,0 +1,177 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+
+#include "ringbuffer_seq.h"
+#include <string.h>
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_seq_init(ringbuffer_seq_t* s, ringbuffer_t* rb) {
+
+    /* Sanity check: make sure input pointers are ok */
+    if (s == 0 || rb == 0) {
+        /* >>> Invalid pointer(s) >>> */
+        return -1;
+    }
+
+    s->rb = rb;
+    __atomic_store_n(&s->head, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&s->tail, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&s->lost, 0, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_seq_write_block(ringbuffer_seq_t* s,
+        const uint8_t* block, size_t len, int lossy) {
+
+    if (s == 0 || block == 0) {
+        /* >>> Invalid pointer(s) >>> */
+        return -1;
+    }
+
+    size_t need = sizeof(size_t) + sizeof(uint64_t) + len;
+
+    if (need > s->rb->size) {
+        /* >>> Block will never fit >>> */
+        return -1;
+    }
+
+    /* Evict the oldest blocks until the new one fits; the consumer will
+     * notice the gap in the sequence */
+    while (lossy && need > (size_t)(s->rb->size - s->rb->len)) {
+        if (ringbuffer_discard_block(s->rb) <= 0) {
+            break;
+        }
+    }
+
+    /* Only the producer updates <head> */
+    uint64_t head = __atomic_load_n(&s->head, __ATOMIC_RELAXED);
+
+    uint8_t header[sizeof(uint64_t)];
+    memcpy(header, &head, sizeof(header));
+
+    int n = ringbuffer_write_frame(s->rb,
+            header, sizeof(header), (uint8_t*)block, len);
+    if (n > 0) {
+        __atomic_store_n(&s->head, head + 1, __ATOMIC_RELEASE);
+    }
+
+    return n;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_seq_read_block(ringbuffer_seq_t* s,
+        uint8_t* block, size_t len, uint64_t* seq, uint64_t* gap) {
+
+    if (s == 0) {
+        /* >>> Invalid pointer to sequence state >>> */
+        return -1;
+    }
+
+    uint8_t header[sizeof(uint64_t)];
+    int plen = ringbuffer_read_frame(s->rb,
+            header, sizeof(header), block, len);
+
+    if (plen < 0) {
+        /* >>> No block or block doesn't fit >>> */
+        return -1;
+    }
+
+    uint64_t n;
+    memcpy(&n, header, sizeof(n));
+
+    /* Blocks skipped in the sequence were missed (only the consumer updates
+     * <tail> and <lost>) */
+    uint64_t missed = n - __atomic_load_n(&s->tail, __ATOMIC_RELAXED);
+    __atomic_store_n(&s->lost,
+            __atomic_load_n(&s->lost, __ATOMIC_RELAXED) + missed,
+            __ATOMIC_RELEASE);
+    __atomic_store_n(&s->tail, n + 1, __ATOMIC_RELEASE);
+
+    if (seq != 0) {
+        *seq = n;
+    }
+    if (gap != 0) {
+        *gap = missed;
+    }
+
+    return plen;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+uint64_t ringbuffer_seq_get_producer(ringbuffer_seq_t* s) {
+
+    return (s != 0) ? __atomic_load_n(&s->head, __ATOMIC_ACQUIRE) : 0;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+uint64_t ringbuffer_seq_get_consumer(ringbuffer_seq_t* s) {
+
+    return (s != 0) ? __atomic_load_n(&s->tail, __ATOMIC_ACQUIRE) : 0;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+uint64_t ringbuffer_seq_get_lag(ringbuffer_seq_t* s) {
+
+    if (s == 0) {
+        return 0;
+    }
+
+    /* Load <tail> first: <head> never falls behind it */
+    uint64_t tail = __atomic_load_n(&s->tail, __ATOMIC_ACQUIRE);
+    uint64_t head = __atomic_load_n(&s->head, __ATOMIC_ACQUIRE);
+
+    return head - tail;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+uint64_t ringbuffer_seq_get_lost(ringbuffer_seq_t* s) {
+
+    return (s != 0) ? __atomic_load_n(&s->lost, __ATOMIC_ACQUIRE) : 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+
+#ifndef RINGBUFFER_SEQ_H_
+#define RINGBUFFER_SEQ_H_
+
+#include "ringbuffer.h"
+
+
+/*
+ * Sequence-numbered blocks: every block is stored as a frame whose header
+ * is a 64-bit sequence number assigned by the producer. The consumer learns
+ * about blocks it missed (e.g. evicted by a lossy producer) from gaps in the
+ * sequence, and lag is known without walking the ringbuffer. The counters
+ * are accessed atomically, so they may be queried from any thread while the
+ * producer and the consumer update them.
+ */
+typedef struct {
+
+    /* the ringbuffer */
+    ringbuffer_t* rb;
+
+    /* next sequence number to assign (producer side) */
+    uint64_t head;
+
+    /* next sequence number expected (consumer side) */
+    uint64_t tail;
+
+    /* total number of blocks missed by the consumer */
+    uint64_t lost;
+
+} ringbuffer_seq_t;
+
+
+/* ========================================================================= */
+
+/*
+ * Sets up sequence-numbered blocks on (empty) ringbuffer <rb>.
+ */
+int ringbuffer_seq_init(ringbuffer_seq_t* s, ringbuffer_t* rb);
+
+
+/*
+ * Writes a block of <len> bytes with the next sequence number. If <lossy>
+ * is non-zero, the oldest blocks are evicted to make room if necessary.
+ * Returns the number of bytes written including headers, or -1 if there is
+ * not enough space.
+ */
+int ringbuffer_seq_write_block(ringbuffer_seq_t* s,
+        const uint8_t* block, size_t len, int lossy);
+
+
+/*
+ * Reads the next block (at most <len> bytes) and stores its sequence number
+ * in <seq> and the number of blocks missed right before it in <gap> (either
+ * may be 0). Returns the payload length, or -1 if there is no block or it
+ * doesn't fit into <block>.
+ */
+int ringbuffer_seq_read_block(ringbuffer_seq_t* s,
+        uint8_t* block, size_t len, uint64_t* seq, uint64_t* gap);
+
+
+/*
+ * Returns the sequence number the producer will assign next.
+ */
+uint64_t ringbuffer_seq_get_producer(ringbuffer_seq_t* s);
+
+
+/*
+ * Returns the sequence number the consumer expects next.
+ */
+uint64_t ringbuffer_seq_get_consumer(ringbuffer_seq_t* s);
+
+
+/*
+ * Returns the number of blocks written but not read by the consumer
+ * (including blocks evicted but not noticed by the consumer yet).
+ */
+uint64_t ringbuffer_seq_get_lag(ringbuffer_seq_t* s);
+
+
+/*
+ * Returns the total number of blocks the consumer has missed.
+ */
+uint64_t ringbuffer_seq_get_lost(ringbuffer_seq_t* s);
+
+#endif
@@ -0,0 +1,267 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef RINGBUFFER_STATIC_H_
+#define RINGBUFFER_STATIC_H_
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+
+/*
+ * Feature flags of ringbuffers generated by RINGBUFFER_DEFINE
+ */
+
+/* check pointers passed to functions (and block lengths read) */
+#define RINGBUFFER_F_CHECKED    0x01
+
+/* use 1, 2 or 4 byte block length fields (default: sizeof(size_t)) */
+#define RINGBUFFER_F_HDR8       0x02
+#define RINGBUFFER_F_HDR16      0x04
+#define RINGBUFFER_F_HDR32      0x08
+
+
+/*
+ * Width of the block length field for feature flags <flags>
+ */
+#define RINGBUFFER_HLEN(flags)                                                \
+    (((flags) & RINGBUFFER_F_HDR8) ? (size_t)1 :                              \
+     ((flags) & RINGBUFFER_F_HDR16) ? (size_t)2 :                             \
+     ((flags) & RINGBUFFER_F_HDR32) ? (size_t)4 : sizeof(size_t))
+
+
+/*
+ * Generates a ringbuffer type <prefix>_t of constant <capacity> bytes (must
+ * be a power of two) with its buffer inline, along with static inline
+ * functions <prefix>_init, _write, _write_all, _read, _peek, _peek_offset,
+ * _discard, _get_length, _get_space and block functions _write_block,
+ * _read_block, _peek_block_length and _discard_block. These behave like
+ * their ringbuffer_* counterparts, but with capacity, header width and
+ * <flags> known at compile time the compiler folds sizes, wraps indices by
+ * masking and drops disabled checks. Unused functions generate no code.
+ * Without RINGBUFFER_F_CHECKED, block lengths read are trusted and only
+ * asserted (like the ringbuffer_*_nocheck functions).
+ */
+#define RINGBUFFER_DEFINE(prefix, capacity, flags)                            \
+/* ring type with inline buffer and free-running indices */                  \
+typedef struct {                                                             \
+    size_t iw;                                                               \
+    size_t ir;                                                               \
+    uint8_t buffer[(capacity)];                                              \
+} prefix##_t;                                                                \
+                                                                             \
+/* compile-time check: capacity must be a power of two */                    \
+typedef char prefix##_capacity_check[                                        \
+        ((capacity) > 0 && ((capacity) & ((capacity) - 1)) == 0) ? 1 : -1];  \
+                                                                             \
+static inline int prefix##_init(prefix##_t* rb) {                            \
+    if (((flags) & RINGBUFFER_F_CHECKED) && rb == 0) {                       \
+        return -1;                                                           \
+    }                                                                        \
+    rb->iw = 0;                                                              \
+    rb->ir = 0;                                                              \
+    return (capacity);                                                       \
+}                                                                            \
+                                                                             \
+static inline int prefix##_get_length(const prefix##_t* rb) {                \
+    return (int)(rb->iw - rb->ir);                                           \
+}                                                                            \
+                                                                             \
+static inline int prefix##_get_space(const prefix##_t* rb) {                 \
+    return (int)((capacity) - (rb->iw - rb->ir));                            \
+}                                                                            \
+                                                                             \
+static inline void prefix##_copy_in(                                         \
+        prefix##_t* rb, size_t pos, const uint8_t* data, size_t len) {       \
+    /* wrap by masking instead of comparing against the size */              \
+    size_t i = pos & ((capacity) - 1);                                       \
+    size_t linlen = (capacity) - i;                                          \
+    if (len <= linlen) {                                                     \
+        memcpy(rb->buffer + i, data, len);                                   \
+    } else {                                                                 \
+        memcpy(rb->buffer + i, data, linlen);                                \
+        memcpy(rb->buffer, data + linlen, len - linlen);                     \
+    }                                                                        \
+}                                                                            \
+                                                                             \
+static inline void prefix##_copy_out(                                        \
+        const prefix##_t* rb, size_t pos, uint8_t* data, size_t len) {       \
+    size_t i = pos & ((capacity) - 1);                                       \
+    size_t linlen = (capacity) - i;                                          \
+    if (len <= linlen) {                                                     \
+        memcpy(data, rb->buffer + i, len);                                   \
+    } else {                                                                 \
+        memcpy(data, rb->buffer + i, linlen);                                \
+        memcpy(data + linlen, rb->buffer, len - linlen);                     \
+    }                                                                        \
+}                                                                            \
+                                                                             \
+static inline int prefix##_write(                                            \
+        prefix##_t* rb, const uint8_t* data, size_t len) {                   \
+    if (((flags) & RINGBUFFER_F_CHECKED) && (rb == 0 || data == 0)) {        \
+        return -1;                                                           \
+    }                                                                        \
+    size_t space = (capacity) - (rb->iw - rb->ir);                           \
+    if (len > space) {                                                       \
+        len = space;                                                         \
+    }                                                                        \
+    prefix##_copy_in(rb, rb->iw, data, len);                                 \
+    rb->iw += len;                                                           \
+    return (int)len;                                                         \
+}                                                                            \
+                                                                             \
+static inline int prefix##_write_all(                                        \
+        prefix##_t* rb, const uint8_t* data, size_t len) {                   \
+    if (((flags) & RINGBUFFER_F_CHECKED) && (rb == 0 || data == 0)) {        \
+        return -1;                                                           \
+    }                                                                        \
+    if (len > (capacity) - (rb->iw - rb->ir)) {                              \
+        return -1;                                                           \
+    }                                                                        \
+    prefix##_copy_in(rb, rb->iw, data, len);                                 \
+    rb->iw += len;                                                           \
+    return (int)len;                                                         \
+}                                                                            \
+                                                                             \
+static inline int prefix##_peek_offset(                                      \
+        const prefix##_t* rb, size_t offset, uint8_t* data, size_t len) {    \
+    if (((flags) & RINGBUFFER_F_CHECKED) && (rb == 0 || data == 0)) {        \
+        return -1;                                                           \
+    }                                                                        \
+    size_t avail = rb->iw - rb->ir;                                          \
+    avail = (offset < avail) ? (avail - offset) : 0;                         \
+    if (len > avail) {                                                       \
+        len = avail;                                                         \
+    }                                                                        \
+    prefix##_copy_out(rb, rb->ir + offset, data, len);                       \
+    return (int)len;                                                         \
+}                                                                            \
+                                                                             \
+static inline int prefix##_peek(                                             \
+        const prefix##_t* rb, uint8_t* data, size_t len) {                   \
+    return prefix##_peek_offset(rb, 0, data, len);                           \
+}                                                                            \
+                                                                             \
+static inline int prefix##_discard(prefix##_t* rb, size_t len) {             \
+    if (((flags) & RINGBUFFER_F_CHECKED) && rb == 0) {                       \
+        return -1;                                                           \
+    }                                                                        \
+    if (len > rb->iw - rb->ir) {                                             \
+        len = rb->iw - rb->ir;                                               \
+    }                                                                        \
+    rb->ir += len;                                                           \
+    return (int)len;                                                         \
+}                                                                            \
+                                                                             \
+static inline int prefix##_read(prefix##_t* rb, uint8_t* data, size_t len) { \
+    int n = prefix##_peek_offset(rb, 0, data, len);                          \
+    if (n > 0) {                                                             \
+        rb->ir += (size_t)n;                                                 \
+    }                                                                        \
+    return n;                                                                \
+}                                                                            \
+                                                                             \
+static inline int prefix##_write_block(                                      \
+        prefix##_t* rb, const uint8_t* block, size_t len) {                  \
+    if (((flags) & RINGBUFFER_F_CHECKED) && (rb == 0 || block == 0)) {       \
+        return -1;                                                           \
+    }                                                                        \
+    const size_t hlen = RINGBUFFER_HLEN(flags);                              \
+    /* (shift in two steps to stay below the width of size_t) */             \
+    if ((len >> (4 * hlen) >> (4 * hlen)) != 0                               \
+            || hlen + len > (capacity) - (rb->iw - rb->ir)) {                \
+        return -1;                                                           \
+    }                                                                        \
+    /* store length little-endian with constant width */                     \
+    uint8_t hdr[sizeof(size_t)];                                             \
+    for (size_t i = 0; i < hlen; i++) {                                      \
+        hdr[i] = (uint8_t)(len >> (8 * i));                                  \
+    }                                                                        \
+    prefix##_copy_in(rb, rb->iw, hdr, hlen);                                 \
+    prefix##_copy_in(rb, rb->iw + hlen, block, len);                         \
+    rb->iw += hlen + len;                                                    \
+    return (int)(hlen + len);                                                \
+}                                                                            \
+                                                                             \
+static inline size_t prefix##_load_length(const prefix##_t* rb) {            \
+    /* load length little-endian with constant width */                      \
+    const size_t hlen = RINGBUFFER_HLEN(flags);                              \
+    uint8_t hdr[sizeof(size_t)];                                             \
+    prefix##_copy_out(rb, rb->ir, hdr, hlen);                                \
+    size_t bl = 0;                                                           \
+    for (size_t i = 0; i < hlen; i++) {                                      \
+        bl |= (size_t)hdr[i] << (8 * i);                                     \
+    }                                                                        \
+    return bl;                                                               \
+}                                                                            \
+                                                                             \
+static inline int prefix##_peek_block_length(const prefix##_t* rb) {         \
+    if (((flags) & RINGBUFFER_F_CHECKED) && rb == 0) {                       \
+        return 0;                                                            \
+    }                                                                        \
+    if (rb->iw - rb->ir < RINGBUFFER_HLEN(flags)) {                          \
+        return 0;                                                            \
+    }                                                                        \
+    size_t bl = prefix##_load_length(rb);                                    \
+    if (((flags) & RINGBUFFER_F_CHECKED)                                     \
+            && RINGBUFFER_HLEN(flags) + bl > rb->iw - rb->ir) {              \
+        return -1;                                                           \
+    }                                                                        \
+    return (int)bl;                                                          \
+}                                                                            \
+                                                                             \
+static inline int prefix##_read_block(                                       \
+        prefix##_t* rb, uint8_t* block, size_t len) {                        \
+    if (((flags) & RINGBUFFER_F_CHECKED) && (rb == 0 || block == 0)) {       \
+        return 0;                                                            \
+    }                                                                        \
+    const size_t hlen = RINGBUFFER_HLEN(flags);                              \
+    if (rb->iw - rb->ir < hlen) {                                            \
+        return 0;                                                            \
+    }                                                                        \
+    size_t bl = prefix##_load_length(rb);                                    \
+    if (hlen + bl > rb->iw - rb->ir || len < bl) {                           \
+        return 0;                                                            \
+    }                                                                        \
+    prefix##_copy_out(rb, rb->ir + hlen, block, bl);                         \
+    rb->ir += hlen + bl;                                                     \
+    return (int)bl;                                                          \
+}                                                                            \
+                                                                             \
+static inline int prefix##_discard_block(prefix##_t* rb) {                   \
+    int bl = prefix##_peek_block_length(rb);                                 \
+    if (bl <= 0) {                                                           \
+        return 0;                                                            \
+    }                                                                        \
+    /* unchecked rings trust the length field: catch corrupt ones early */   \
+    assert(RINGBUFFER_HLEN(flags) + (size_t)bl <= rb->iw - rb->ir);          \
+    rb->ir += RINGBUFFER_HLEN(flags) + (size_t)bl;                           \
+    return (int)(RINGBUFFER_HLEN(flags) + (size_t)bl);                       \
+}
+
+#endif
@@ -0,0 +1,255 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "ringbuffer_trace.h"
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+
+
+/* Trace file magic and format version */
+static const uint8_t ringbuffer_trace_magic[4] = { 'R', 'B', 'T', 'R' };
+#define RINGBUFFER_TRACE_VERSION 1
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static uint64_t ringbuffer_trace_now(void) {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void ringbuffer_trace_put_varint(FILE* file, uint64_t value) {
+
+    /* 7 bits per byte, MSB set on all but the last byte */
+    while (value >= 0x80) {
+        fputc((int)(value & 0x7F) | 0x80, file);
+        value >>= 7;
+    }
+    fputc((int)value, file);
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static int ringbuffer_trace_get_varint(FILE* file, uint64_t* value) {
+
+    *value = 0;
+
+    for (int shift = 0; shift < 64; shift += 7) {
+
+        int c = fgetc(file);
+        if (c == EOF) {
+            /* >>> Truncated value >>> */
+            return -1;
+        }
+
+        *value |= (uint64_t)(c & 0x7F) << shift;
+        if ((c & 0x80) == 0) {
+            return 0;
+        }
+    }
+
+    /* >>> Value too long >>> */
+    return -1;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static void ringbuffer_trace_record(void* ctx,
+        ringbuffer_t* rb, int op, size_t len, size_t aux) {
+
+    ringbuffer_trace_t* tr = (ringbuffer_trace_t*)ctx;
+
+    if (tr->rb != rb) {
+        /* >>> Operation on another ringbuffer >>> */
+        return;
+    }
+
+    uint64_t now = ringbuffer_trace_now();
+
+    fputc(op, tr->file);
+    ringbuffer_trace_put_varint(tr->file, len);
+    ringbuffer_trace_put_varint(tr->file, aux);
+    ringbuffer_trace_put_varint(tr->file, now - tr->last);
+
+    tr->last = now;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_trace_start(
+        ringbuffer_trace_t* tr, const char* path, ringbuffer_t* rb) {
+
+    if (tr == 0 || path == 0 || rb == 0) {
+        /* >>> Invalid pointer(s) >>> */
+        return -1;
+    }
+
+    tr->file = fopen(path, "wb");
+    if (tr->file == 0) {
+        /* >>> Cannot create trace file >>> */
+        return -1;
+    }
+
+    tr->rb = rb;
+    tr->size = rb->size;
+    tr->last = ringbuffer_trace_now();
+
+    /* Write trace header */
+    fwrite(ringbuffer_trace_magic, 1, sizeof(ringbuffer_trace_magic), tr->file);
+    fputc(RINGBUFFER_TRACE_VERSION, tr->file);
+    ringbuffer_trace_put_varint(tr->file, tr->size);
+
+    if (ringbuffer_set_trace_hook(ringbuffer_trace_record, tr) < 0) {
+        /* >>> Tracing not compiled into the library >>> */
+        fclose(tr->file);
+        tr->file = 0;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_trace_stop(ringbuffer_trace_t* tr) {
+
+    if (tr == 0 || tr->file == 0) {
+        return -1;
+    }
+
+    ringbuffer_set_trace_hook(0, 0);
+
+    int ret = fclose(tr->file);
+    tr->file = 0;
+
+    return (ret == 0) ? 0 : -1;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_trace_open(ringbuffer_trace_t* tr, const char* path) {
+
+    if (tr == 0 || path == 0) {
+        /* >>> Invalid pointer(s) >>> */
+        return -1;
+    }
+
+    tr->file = fopen(path, "rb");
+    if (tr->file == 0) {
+        /* >>> Cannot open trace file >>> */
+        return -1;
+    }
+
+    /* Check trace header */
+    uint8_t magic[sizeof(ringbuffer_trace_magic)];
+    uint64_t size;
+    if (fread(magic, 1, sizeof(magic), tr->file) != sizeof(magic)
+            || memcmp(magic, ringbuffer_trace_magic, sizeof(magic)) != 0
+            || fgetc(tr->file) != RINGBUFFER_TRACE_VERSION
+            || ringbuffer_trace_get_varint(tr->file, &size) < 0
+            || size > INT_MAX) {
+        /* >>> Not a trace file (or unsupported version or size) >>> */
+        fclose(tr->file);
+        tr->file = 0;
+        return -1;
+    }
+
+    tr->rb = 0;
+    tr->size = size;
+    tr->last = 0;
+
+    return tr->size;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_trace_next(
+        ringbuffer_trace_t* tr, ringbuffer_trace_record_t* rec) {
+
+    if (tr == 0 || tr->file == 0 || rec == 0) {
+        return -1;
+    }
+
+    int op = fgetc(tr->file);
+    if (op == EOF) {
+        /* >>> End of trace >>> */
+        return 0;
+    }
+
+    uint64_t len, aux, delta;
+    if (ringbuffer_trace_get_varint(tr->file, &len) < 0
+            || ringbuffer_trace_get_varint(tr->file, &aux) < 0
+            || ringbuffer_trace_get_varint(tr->file, &delta) < 0) {
+        /* >>> Truncated record >>> */
+        return -1;
+    }
+
+    rec->op = op;
+    rec->len = len;
+    rec->aux = aux;
+    rec->delta = delta;
+
+    return 1;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_trace_close(ringbuffer_trace_t* tr) {
+
+    if (tr == 0 || tr->file == 0) {
+        return -1;
+    }
+
+    fclose(tr->file);
+    tr->file = 0;
+
+    return 0;
+}
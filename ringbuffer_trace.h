@@ -0,0 +1,113 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef RINGBUFFER_TRACE_H_
+#define RINGBUFFER_TRACE_H_
+
+#include "ringbuffer.h"
+#include <stdio.h>
+
+
+/*
+ * A trace file being recorded or replayed. A trace starts with the magic
+ * "RBTR", a version byte and the traced ringbuffer's size, followed by one
+ * record per operation: the operation byte and the varint-encoded length,
+ * auxiliary value and time since the previous record (in nanoseconds).
+ */
+typedef struct {
+
+    /* the trace file */
+    FILE* file;
+
+    /* the ringbuffer whose operations are recorded */
+    ringbuffer_t* rb;
+
+    /* size of the traced ringbuffer */
+    size_t size;
+
+    /* timestamp of the previous record (ns) */
+    uint64_t last;
+
+} ringbuffer_trace_t;
+
+
+/*
+ * A single recorded operation
+ */
+typedef struct {
+
+    /* operation (RINGBUFFER_OP_*) */
+    int op;
+
+    /* requested length */
+    size_t len;
+
+    /* offset (peek/find) or header length (frames) */
+    size_t aux;
+
+    /* time since the previous record (ns) */
+    uint64_t delta;
+
+} ringbuffer_trace_record_t;
+
+
+/* ========================================================================= */
+
+/*
+ * Starts recording operations on ringbuffer <rb> into file <path>. Only one
+ * trace can be recorded at a time. Requires the library to be compiled with
+ * RINGBUFFER_TRACE defined.
+ */
+int ringbuffer_trace_start(
+        ringbuffer_trace_t* tr, const char* path, ringbuffer_t* rb);
+
+
+/*
+ * Stops recording and closes the trace file.
+ */
+int ringbuffer_trace_stop(ringbuffer_trace_t* tr);
+
+
+/*
+ * Opens trace file <path> for replay. Returns the traced ringbuffer's size.
+ */
+int ringbuffer_trace_open(ringbuffer_trace_t* tr, const char* path);
+
+
+/*
+ * Reads the next record of a trace opened for replay. Returns 1 if a record
+ * has been read, 0 at the end of the trace, or -1 if the trace is corrupt.
+ */
+int ringbuffer_trace_next(
+        ringbuffer_trace_t* tr, ringbuffer_trace_record_t* rec);
+
+
+/*
+ * Closes a trace opened for replay.
+ */
+int ringbuffer_trace_close(ringbuffer_trace_t* tr);
+
+#endif
@@ -0,0 +1,387 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+
+#include "ringbuffer_utf8.h"
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+
+/*
+ * ___________________________________________________________________________
+ */
+static size_t ringbuffer_utf8_skip_ascii(const uint8_t* p, size_t len) {
+
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    /* Skip 16 bytes at a time as long as none has its top bit set */
+    while (i + 16 <= len && _mm_movemask_epi8(
+            _mm_loadu_si128((const __m128i*)(p + i))) == 0) {
+        i += 16;
+    }
+#endif
+
+    /* Skip 8 bytes at a time (or what's left of the vector loop) */
+    while (i + 8 <= len) {
+        uint64_t w;
+        memcpy(&w, p + i, sizeof(w));
+        if ((w & 0x8080808080808080ULL) != 0) {
+            break;
+        }
+        i += 8;
+    }
+
+    return i;
+}
+
+
+#if defined(__SSSE3__) && defined(__GNUC__)
+
+/*
+ * Error classes of the nibble lookup classifier: a pair of consecutive bytes
+ * is invalid if the three tables indexed by the first byte's high and low
+ * nibble and the second byte's high nibble share a bit
+ */
+#define RINGBUFFER_UTF8_TOO_SHORT       0x01
+#define RINGBUFFER_UTF8_TOO_LONG        0x02
+#define RINGBUFFER_UTF8_OVERLONG_3      0x04
+#define RINGBUFFER_UTF8_TOO_LARGE       0x08
+#define RINGBUFFER_UTF8_SURROGATE       0x10
+#define RINGBUFFER_UTF8_OVERLONG_2      0x20
+#define RINGBUFFER_UTF8_TOO_LARGE_1000  0x40
+#define RINGBUFFER_UTF8_OVERLONG_4      0x40
+#define RINGBUFFER_UTF8_TWO_CONTS       0x80
+#define RINGBUFFER_UTF8_CARRY           (RINGBUFFER_UTF8_TOO_SHORT \
+        | RINGBUFFER_UTF8_TOO_LONG | RINGBUFFER_UTF8_TWO_CONTS)
+
+
+/*
+ * Classifies 16 bytes at <p> that start at a sequence boundary. Returns
+ * non-zero if they contain an invalid sequence (a sequence cut by the end of
+ * the 16 bytes is not checked for completeness).
+ * ___________________________________________________________________________
+ */
+static int ringbuffer_utf8_classify16(const uint8_t* p) {
+
+    const __m128i byte_1_high = _mm_setr_epi8(
+            /* 0xxx: ASCII */
+            RINGBUFFER_UTF8_TOO_LONG, RINGBUFFER_UTF8_TOO_LONG,
+            RINGBUFFER_UTF8_TOO_LONG, RINGBUFFER_UTF8_TOO_LONG,
+            RINGBUFFER_UTF8_TOO_LONG, RINGBUFFER_UTF8_TOO_LONG,
+            RINGBUFFER_UTF8_TOO_LONG, RINGBUFFER_UTF8_TOO_LONG,
+            /* 10xx: continuation */
+            (char)RINGBUFFER_UTF8_TWO_CONTS, (char)RINGBUFFER_UTF8_TWO_CONTS,
+            (char)RINGBUFFER_UTF8_TWO_CONTS, (char)RINGBUFFER_UTF8_TWO_CONTS,
+            /* 1100, 1101: two-byte lead */
+            RINGBUFFER_UTF8_TOO_SHORT | RINGBUFFER_UTF8_OVERLONG_2,
+            RINGBUFFER_UTF8_TOO_SHORT,
+            /* 1110: three-byte lead */
+            RINGBUFFER_UTF8_TOO_SHORT | RINGBUFFER_UTF8_OVERLONG_3
+                    | RINGBUFFER_UTF8_SURROGATE,
+            /* 1111: four-byte lead (or invalid) */
+            RINGBUFFER_UTF8_TOO_SHORT | RINGBUFFER_UTF8_TOO_LARGE
+                    | RINGBUFFER_UTF8_TOO_LARGE_1000
+                    | RINGBUFFER_UTF8_OVERLONG_4);
+
+    const __m128i byte_1_low = _mm_setr_epi8(
+            /* xxxx0000, xxxx0001 */
+            RINGBUFFER_UTF8_CARRY | RINGBUFFER_UTF8_OVERLONG_3
+                    | RINGBUFFER_UTF8_OVERLONG_2 | RINGBUFFER_UTF8_OVERLONG_4,
+            RINGBUFFER_UTF8_CARRY | RINGBUFFER_UTF8_OVERLONG_2,
+            /* xxxx001x */
+            RINGBUFFER_UTF8_CARRY, RINGBUFFER_UTF8_CARRY,
+            /* xxxx0100, xxxx0101 */
+            RINGBUFFER_UTF8_CARRY | RINGBUFFER_UTF8_TOO_LARGE,
+            RINGBUFFER_UTF8_CARRY | RINGBUFFER_UTF8_TOO_LARGE
+                    | RINGBUFFER_UTF8_TOO_LARGE_1000,
+            /* xxxx011x, xxxx1xxx (except xxxx1101) */
+            RINGBUFFER_UTF8_CARRY | RINGBUFFER_UTF8_TOO_LARGE
+                    | RINGBUFFER_UTF8_TOO_LARGE_1000,
+            RINGBUFFER_UTF8_CARRY | RINGBUFFER_UTF8_TOO_LARGE
+                    | RINGBUFFER_UTF8_TOO_LARGE_1000,
+            RINGBUFFER_UTF8_CARRY | RINGBUFFER_UTF8_TOO_LARGE
+                    | RINGBUFFER_UTF8_TOO_LARGE_1000,
+            RINGBUFFER_UTF8_CARRY | RINGBUFFER_UTF8_TOO_LARGE
+                    | RINGBUFFER_UTF8_TOO_LARGE_1000,
+            RINGBUFFER_UTF8_CARRY | RINGBUFFER_UTF8_TOO_LARGE
+                    | RINGBUFFER_UTF8_TOO_LARGE_1000,
+            RINGBUFFER_UTF8_CARRY | RINGBUFFER_UTF8_TOO_LARGE
+                    | RINGBUFFER_UTF8_TOO_LARGE_1000,
+            RINGBUFFER_UTF8_CARRY | RINGBUFFER_UTF8_TOO_LARGE
+                    | RINGBUFFER_UTF8_TOO_LARGE_1000,
+            /* xxxx1101 */
+            RINGBUFFER_UTF8_CARRY | RINGBUFFER_UTF8_TOO_LARGE
+                    | RINGBUFFER_UTF8_TOO_LARGE_1000
+                    | RINGBUFFER_UTF8_SURROGATE,
+            RINGBUFFER_UTF8_CARRY | RINGBUFFER_UTF8_TOO_LARGE
+                    | RINGBUFFER_UTF8_TOO_LARGE_1000,
+            RINGBUFFER_UTF8_CARRY | RINGBUFFER_UTF8_TOO_LARGE
+                    | RINGBUFFER_UTF8_TOO_LARGE_1000);
+
+    const __m128i byte_2_high = _mm_setr_epi8(
+            /* 0xxx: ASCII */
+            RINGBUFFER_UTF8_TOO_SHORT, RINGBUFFER_UTF8_TOO_SHORT,
+            RINGBUFFER_UTF8_TOO_SHORT, RINGBUFFER_UTF8_TOO_SHORT,
+            RINGBUFFER_UTF8_TOO_SHORT, RINGBUFFER_UTF8_TOO_SHORT,
+            RINGBUFFER_UTF8_TOO_SHORT, RINGBUFFER_UTF8_TOO_SHORT,
+            /* 1000, 1001, 101x: continuation */
+            (char)(RINGBUFFER_UTF8_TOO_LONG | RINGBUFFER_UTF8_OVERLONG_2
+                    | RINGBUFFER_UTF8_TWO_CONTS | RINGBUFFER_UTF8_OVERLONG_3
+                    | RINGBUFFER_UTF8_TOO_LARGE_1000
+                    | RINGBUFFER_UTF8_OVERLONG_4),
+            (char)(RINGBUFFER_UTF8_TOO_LONG | RINGBUFFER_UTF8_OVERLONG_2
+                    | RINGBUFFER_UTF8_TWO_CONTS | RINGBUFFER_UTF8_OVERLONG_3
+                    | RINGBUFFER_UTF8_TOO_LARGE),
+            (char)(RINGBUFFER_UTF8_TOO_LONG | RINGBUFFER_UTF8_OVERLONG_2
+                    | RINGBUFFER_UTF8_TWO_CONTS | RINGBUFFER_UTF8_SURROGATE
+                    | RINGBUFFER_UTF8_TOO_LARGE),
+            (char)(RINGBUFFER_UTF8_TOO_LONG | RINGBUFFER_UTF8_OVERLONG_2
+                    | RINGBUFFER_UTF8_TWO_CONTS | RINGBUFFER_UTF8_SURROGATE
+                    | RINGBUFFER_UTF8_TOO_LARGE),
+            /* 11xx: lead */
+            RINGBUFFER_UTF8_TOO_SHORT, RINGBUFFER_UTF8_TOO_SHORT,
+            RINGBUFFER_UTF8_TOO_SHORT, RINGBUFFER_UTF8_TOO_SHORT);
+
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i zero = _mm_setzero_si128();
+
+    /* The bytes before <p> end a sequence, so they count as ASCII (zero) */
+    __m128i input = _mm_loadu_si128((const __m128i*)p);
+    __m128i prev1 = _mm_alignr_epi8(input, zero, 15);
+    __m128i prev2 = _mm_alignr_epi8(input, zero, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, zero, 13);
+
+    /* Errors within pairs of consecutive bytes */
+    __m128i sc = _mm_and_si128(_mm_and_si128(
+            _mm_shuffle_epi8(byte_1_high,
+                    _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+            _mm_shuffle_epi8(byte_1_low, _mm_and_si128(prev1, nibble))),
+            _mm_shuffle_epi8(byte_2_high,
+                    _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+
+    /* Third and fourth bytes of a sequence must be continuations, which
+     * the pair check flags as TWO_CONTS: flip that bit for them */
+    __m128i must23 = _mm_or_si128(
+            _mm_subs_epu8(prev2, _mm_set1_epi8(0xE0 - 0x80)),
+            _mm_subs_epu8(prev3, _mm_set1_epi8(0xF0 - 0x80)));
+    __m128i err = _mm_xor_si128(sc,
+            _mm_and_si128(must23, _mm_set1_epi8((char)0x80)));
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(err, zero)) != 0xFFFF;
+}
+
+
+/*
+ * Skips valid content at <p> 16 bytes at a time, starting at a sequence
+ * boundary. Returns the number of bytes skipped, which always ends at a
+ * sequence boundary (a sequence cut by a 16-byte chunk's end is revisited
+ * with the next chunk).
+ * ___________________________________________________________________________
+ */
+static size_t ringbuffer_utf8_skip_valid(const uint8_t* p, size_t len) {
+
+    size_t i = 0;
+
+    while (i + 16 <= len) {
+
+        if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(p + i))) == 0) {
+            /* >>> ASCII only >>> */
+            i += 16;
+            continue;
+        }
+
+        if (ringbuffer_utf8_classify16(p + i) != 0) {
+            /* >>> Invalid sequence: leave it to the scalar machine >>> */
+            break;
+        }
+
+        /* Step back to the lead byte of a sequence cut by the chunk's end */
+        if (p[i + 15] >= 0xC0) {
+            i += 15;
+        } else if (p[i + 14] >= 0xE0) {
+            i += 14;
+        } else if (p[i + 13] >= 0xF0) {
+            i += 13;
+        } else {
+            i += 16;
+        }
+    }
+
+    return i;
+}
+
+#endif
+
+
+/*
+ * Validates <len> bytes at <p>, continuing from the state in <v>. Returns the
+ * index of the first invalid byte, or <len> if all bytes are valid.
+ * ___________________________________________________________________________
+ */
+static size_t ringbuffer_utf8_scan(
+        ringbuffer_utf8_t* v, const uint8_t* p, size_t len) {
+
+    size_t i = 0;
+
+    while (i < len) {
+
+#if defined(__SSSE3__) && defined(__GNUC__)
+        if (v->need == 0 && i + 16 <= len) {
+            /* >>> At a sequence boundary: classify 16 bytes at a time (the
+             * state machine below only takes over for sequences cut by the
+             * end of the region and around invalid bytes) >>> */
+            size_t n = ringbuffer_utf8_skip_valid(p + i, len - i);
+            if (n > 0) {
+                i += n;
+                continue;
+            }
+        }
+#endif
+
+        uint8_t b = p[i];
+
+        if (v->need > 0) {
+            /* >>> Inside a multi-byte sequence >>> */
+            if (b < v->lo || b > v->hi) {
+                return i;
+            }
+            v->lo = 0x80;
+            v->hi = 0xBF;
+            v->pending = (--v->need > 0) ? v->pending + 1 : 0;
+            i++;
+            continue;
+        }
+
+        if (b < 0x80) {
+            /* >>> ASCII: skip ahead as far as possible >>> */
+            i += 1 + ringbuffer_utf8_skip_ascii(p + i + 1, len - i - 1);
+            continue;
+        }
+
+        /* Lead byte: determine sequence length and exclude overlong forms,
+         * surrogates and code points beyond U+10FFFF via the range of the
+         * first continuation byte */
+        v->lo = 0x80;
+        v->hi = 0xBF;
+        if (b >= 0xC2 && b <= 0xDF) {
+            v->need = 1;
+        } else if (b >= 0xE0 && b <= 0xEF) {
+            v->need = 2;
+            if (b == 0xE0) {
+                v->lo = 0xA0;
+            } else if (b == 0xED) {
+                v->hi = 0x9F;
+            }
+        } else if (b >= 0xF0 && b <= 0xF4) {
+            v->need = 3;
+            if (b == 0xF0) {
+                v->lo = 0x90;
+            } else if (b == 0xF4) {
+                v->hi = 0x8F;
+            }
+        } else {
+            return i;
+        }
+        v->pending = 1;
+        i++;
+    }
+
+    return len;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_utf8_init(ringbuffer_utf8_t* v) {
+
+    if (v == 0) {
+        /* >>> Invalid pointer to validator >>> */
+        return -1;
+    }
+
+    v->offset = 0;
+    v->pending = 0;
+    v->need = 0;
+    v->lo = 0x80;
+    v->hi = 0xBF;
+
+    return 0;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_utf8_validate(ringbuffer_utf8_t* v, ringbuffer_t* rb) {
+
+    if (v == 0 || rb == 0 || v->offset > rb->len) {
+        /* >>> Invalid pointer(s) or content discarded behind our back >>> */
+        return -1;
+    }
+
+    ringbuffer_segments_t seg;
+    ringbuffer_get_segments(rb, v->offset, rb->len - v->offset, &seg);
+
+    for (int i = 0; i < 2; i++) {
+
+        /* Validate each linear region in place; the state in <v> carries
+         * a sequence cut by the wrap over into the second region */
+        size_t n = ringbuffer_utf8_scan(v, seg.data[i], seg.len[i]);
+        v->offset += n;
+
+        if (n < seg.len[i]) {
+            /* >>> Invalid byte found >>> */
+            return -2;
+        }
+    }
+
+    return v->offset - v->pending;
+}
+
+
+/*
+ * ___________________________________________________________________________
+ */
+int ringbuffer_utf8_consume(ringbuffer_utf8_t* v, size_t len) {
+
+    if (v == 0 || len > v->offset - v->pending) {
+        /* >>> Invalid pointer or content not validated (completely) >>> */
+        return -1;
+    }
+
+    v->offset -= len;
+
+    return len;
+}
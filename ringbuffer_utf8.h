@@ -0,0 +1,85 @@
+/*
+ * ringbuffer-c
+ *
+ * Copyright (C) 2017 Andreas Walz
+ *
+ * Author: Andreas Walz (andreas.walz@hs-offenburg.de)
+ *
+ * This file is part of ringbuffer-c.
+ *
+ * ringbuffer-c is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * ringbuffer-c are distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ringbuffer-c; if not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc., 51 Franklin Street,
+ * Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+
+#ifndef RINGBUFFER_UTF8_H_
+#define RINGBUFFER_UTF8_H_
+
+#include "ringbuffer.h"
+
+
+/*
+ * Incremental UTF-8 validator operating in place on a ringbuffer's content.
+ * Validation state (including a multi-byte sequence that is cut by the end of
+ * the buffer or by the end of the data written so far) is carried across
+ * calls, so newly written bytes are only ever inspected once. If built with
+ * SSSE3 (e.g. -mssse3), content is classified 16 bytes at a time by nibble
+ * table lookups, falling back to a scalar state machine for sequences cut by
+ * the buffer's end and around invalid bytes.
+ */
+typedef struct {
+
+    /* offset (relative to the read index) up to which content is validated */
+    size_t offset;
+
+    /* number of bytes of an incomplete sequence at the end of the region */
+    size_t pending;
+
+    /* number of continuation bytes still expected */
+    uint8_t need;
+
+    /* valid range of the next continuation byte */
+    uint8_t lo;
+    uint8_t hi;
+
+} ringbuffer_utf8_t;
+
+
+/* ========================================================================= */
+
+/*
+ * Resets validator <v> to validate content from the read index onwards.
+ */
+int ringbuffer_utf8_init(ringbuffer_utf8_t* v);
+
+
+/*
+ * Validates the content of <rb> written since the previous call. Returns the
+ * length of the content known to be valid and complete UTF-8, -2 if an
+ * invalid byte was found (<v>->offset then points to the offending byte), or
+ * -1 on invalid input.
+ */
+int ringbuffer_utf8_validate(ringbuffer_utf8_t* v, ringbuffer_t* rb);
+
+
+/*
+ * Rebases validator <v> after <len> bytes of validated content have been
+ * read or discarded from the ringbuffer. <len> must not exceed the length
+ * returned by the last call to ringbuffer_utf8_validate().
+ */
+int ringbuffer_utf8_consume(ringbuffer_utf8_t* v, size_t len);
+
+#endif
@@ -1,10 +1,68 @@
 #include "ringbuffer.h"
+#include "ringbuffer_cmdq.h"
+#include "ringbuffer_compact.h"
+#include "ringbuffer_credit.h"
+#include "ringbuffer_deque.h"
+#include "ringbuffer_dfa.h"
+#include "ringbuffer_hash.h"
+#include "ringbuffer_objq.h"
+#include "ringbuffer_parallel.h"
+#include "ringbuffer_pipeline.h"
+#include "ringbuffer_pubsub.h"
+#include "ringbuffer_replica.h"
+#include "ringbuffer_seq.h"
+#include "ringbuffer_static.h"
+#include "ringbuffer_trace.h"
+#include "ringbuffer_utf8.h"
 #include <stdio.h>
+#include <string.h>
 
 void print(ringbuffer_t* rb);
+void check(const char* what, int ok);
+void test_pipeline(void);
+void test_deque(void);
+void test_objq(void);
+void test_cmdq(void);
+void wrap_fill(ringbuffer_t* rb, uint8_t* mem, size_t size,
+        const uint8_t* data, size_t len, size_t split);
+int naive_find(size_t offset, const uint8_t* data, size_t len);
+void test_compact(void);
+void test_static(void);
+void test_find_wrap(void);
+void test_stream(void);
+int same_state(ringbuffer_t* a, ringbuffer_t* b);
+void test_nocheck(void);
+void test_trace(void);
+void test_utf8(void);
+void test_index_wrap(void);
+void test_find_any_wrap(void);
+void test_dfa(void);
+void test_rfind_wrap(void);
+void test_hash(void);
+void test_parallel(void);
+void test_credit(void);
+int topic_next(ringbuffer_topic_t* t, size_t id, const uint8_t* msg);
+void test_pubsub(void);
+void test_replica(void);
+void test_seq(void);
 
 
-int main(int argc , char *argv[]) {
+/* number of failed checks */
+static int failures = 0;
+
+/* content used for checks across the wrap point (40 bytes) */
+static const uint8_t text[] = "abcabdabcabcabdxyzabcabcabdabxdabcabxyzd";
+
+#define TEXT_LEN (sizeof(text) - 1)
+
+/* ringbuffers generated at compile time: default and narrow length fields,
+ * checked and unchecked */
+RINGBUFFER_DEFINE(srb, 64, RINGBUFFER_F_CHECKED)
+RINGBUFFER_DEFINE(srb8, 512, RINGBUFFER_F_CHECKED | RINGBUFFER_F_HDR8)
+RINGBUFFER_DEFINE(srbu, 64, RINGBUFFER_F_HDR16)
+
+
+int main(void) {
 
     uint8_t mem[8];
 
@@ -36,7 +94,83 @@ int main(int argc , char *argv[]) {
     print(&rb);
     printf("find = %i\n", ringbuffer_find(&rb, 0, &(data[0]), 1));
 
-    return 0;
+    test_pipeline();
+    test_deque();
+    test_objq();
+    test_cmdq();
+    test_compact();
+    test_static();
+    test_find_wrap();
+    test_stream();
+    test_nocheck();
+    test_trace();
+    test_utf8();
+    test_index_wrap();
+    test_find_any_wrap();
+    test_dfa();
+    test_rfind_wrap();
+    test_hash();
+    test_parallel();
+    test_credit();
+    test_pubsub();
+    test_replica();
+    test_seq();
+
+    return (failures == 0) ? 0 : 1;
+}
+
+
+
+void check(const char* what, int ok) {
+
+    printf("%-48s %s\n", what, ok ? "ok" : "FAILED");
+
+    if (!ok) {
+        failures++;
+    }
+}
+
+
+
+void test_deque(void) {
+
+    uint8_t mem[4 * sizeof(int)];
+    ringbuffer_deque_t dq;
+    int r = 0;
+
+    check("deque: 4 slots",
+            ringbuffer_deque_init(&dq, mem, sizeof(mem), sizeof(int)) == 4);
+
+    for (int i = 1; i <= 4; i++) {
+        ringbuffer_deque_push(&dq, (uint8_t*)&i);
+    }
+    r = 5;
+    check("deque: push to full deque fails",
+            ringbuffer_deque_push(&dq, (uint8_t*)&r) == -1);
+
+    check("deque: steal takes oldest",
+            ringbuffer_deque_steal(&dq, (uint8_t*)&r) == sizeof(int) && r == 1);
+    check("deque: pop takes newest",
+            ringbuffer_deque_pop(&dq, (uint8_t*)&r) == sizeof(int) && r == 4);
+    check("deque: pop again",
+            ringbuffer_deque_pop(&dq, (uint8_t*)&r) == sizeof(int) && r == 3);
+    check("deque: steal last record",
+            ringbuffer_deque_steal(&dq, (uint8_t*)&r) == sizeof(int) && r == 2);
+    check("deque: pop from empty deque",
+            ringbuffer_deque_pop(&dq, (uint8_t*)&r) == 0);
+    check("deque: steal from empty deque",
+            ringbuffer_deque_steal(&dq, (uint8_t*)&r) == 0);
+
+    /* Slots are reused across the end of the buffer */
+    for (int i = 6; i <= 9; i++) {
+        ringbuffer_deque_push(&dq, (uint8_t*)&i);
+    }
+    check("deque: length after wrap",
+            ringbuffer_deque_get_length(&dq) == 4);
+    check("deque: steal after wrap",
+            ringbuffer_deque_steal(&dq, (uint8_t*)&r) == sizeof(int) && r == 6);
+    check("deque: pop after wrap",
+            ringbuffer_deque_pop(&dq, (uint8_t*)&r) == sizeof(int) && r == 9);
 }
 
 
@@ -60,4 +194,1242 @@ void print(ringbuffer_t* rb) {
 
 
 
+/* A command adding <value> to <*sum>; destruction is counted */
+typedef struct {
+    int* sum;
+    int value;
+} add_t;
+
+static int destroyed = 0;
+
+static void add_invoke(void* obj) {
+    add_t* a = (add_t*)obj;
+    *a->sum += a->value;
+}
+
+static void add_destroy(void* obj) {
+    (void)obj;
+    destroyed++;
+}
+
+static void add_move(void* dst, void* src) {
+    memcpy(dst, src, sizeof(add_t));
+    ((add_t*)src)->value = 0;
+}
+
+static const ringbuffer_cmdq_ops_t add_ops = { add_invoke, 0, add_destroy };
+static const ringbuffer_cmdq_ops_t add_move_ops = {
+        add_invoke, add_move, add_destroy };
+
+
+
+void test_cmdq(void) {
+
+    uint64_t mem[20];
+    ringbuffer_t rb;
+    int sum = 0;
+    add_t* a;
+
+    ringbuffer_cmdq_init(&rb, (uint8_t*)mem, sizeof(mem));
+
+    for (int i = 1; i <= 3; i++) {
+        a = ringbuffer_cmdq_emplace(&rb, &add_ops, sizeof(add_t));
+        a->sum = &sum;
+        a->value = i;
+    }
+
+    const ringbuffer_cmdq_ops_t* ops = 0;
+    check("cmdq: front has entry type",
+            ringbuffer_cmdq_front(&rb, &ops) != 0 && ops == &add_ops);
+    check("cmdq: invoke runs and destroys oldest",
+            ringbuffer_cmdq_invoke(&rb) == 1 && sum == 1 && destroyed == 1);
+
+    add_t moved;
+    check("cmdq: bitwise move does not destroy",
+            ringbuffer_cmdq_move(&rb, &moved) > 0 && moved.value == 2
+            && destroyed == 1);
+    check("cmdq: run invokes remaining entries",
+            ringbuffer_cmdq_run(&rb) == 1 && sum == 4 && destroyed == 2);
+
+    /* Entries of varying size never wrap (filler entries are skipped) */
+    int expected = sum;
+    int invoked = 0;
+    int linear = 1;
+    for (int i = 0; i < 50; i++) {
+        size_t size = sizeof(add_t) + (i % 3) * 16;
+        while ((a = ringbuffer_cmdq_emplace(&rb, &add_ops, size)) == 0) {
+            invoked += ringbuffer_cmdq_invoke(&rb);
+        }
+        linear = linear && (uint8_t*)a + size <= (uint8_t*)mem + sizeof(mem);
+        a->sum = &sum;
+        a->value = i;
+        expected += i;
+    }
+    invoked += ringbuffer_cmdq_run(&rb);
+    check("cmdq: entries never wrap", linear);
+    check("cmdq: all entries invoked across wraps",
+            invoked == 50 && sum == expected && destroyed == 52);
+
+    a = ringbuffer_cmdq_emplace(&rb, &add_move_ops, sizeof(add_t));
+    a->value = 5;
+    check("cmdq: move function then destroys source",
+            ringbuffer_cmdq_move(&rb, &moved) > 0 && moved.value == 5
+            && destroyed == 53);
+
+    a = ringbuffer_cmdq_emplace(&rb, &add_ops, sizeof(add_t));
+    a->value = 0;
+    check("cmdq: clear destroys entries",
+            ringbuffer_cmdq_clear(&rb) == 1 && destroyed == 54
+            && ringbuffer_cmdq_front(&rb, 0) == 0);
+}
+
+
+
+void wrap_fill(ringbuffer_t* rb, uint8_t* mem, size_t size,
+        const uint8_t* data, size_t len, size_t split) {
+
+    uint8_t junk[128] = { 0 };
+
+    /* Place <data> such that its first <split> bytes precede the wrap
+     * point (0 = no wrap) */
+    ringbuffer_init(rb, mem, size);
+    ringbuffer_write(rb, junk, size - split);
+    ringbuffer_discard(rb, size - split);
+    ringbuffer_write(rb, data, len);
+}
+
+
+
+int naive_find(size_t offset, const uint8_t* data, size_t len) {
+
+    for (size_t i = offset; i + len <= TEXT_LEN; i++) {
+        if (memcmp(text + i, data, len) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+
+
+void test_find_wrap(void) {
+
+    uint8_t mem[48];
+    ringbuffer_t rb;
+    int find_ok = 1;
+    int equal_ok = 1;
+
+    /* Every wrap point, search offset and pattern (taken from the text and
+     * hence crossing the wrap point at every possible position) */
+    for (size_t split = 0; split <= TEXT_LEN; split++) {
+        wrap_fill(&rb, mem, sizeof(mem), text, TEXT_LEN, split);
+        for (size_t pos = 0; pos < TEXT_LEN; pos++) {
+            for (size_t len = 1; len <= 6 && pos + len <= TEXT_LEN; len++) {
+                for (size_t offset = 0; offset <= TEXT_LEN + 1;
+                        offset++) {
+                    find_ok = find_ok && ringbuffer_find(&rb, offset,
+                            (uint8_t*)text + pos, len)
+                            == naive_find(offset, text + pos, len);
+                }
+                equal_ok = equal_ok
+                        && ringbuffer_equal(&rb, pos, text + pos, len) == 1
+                        && ringbuffer_equal(&rb, pos, text + 1, len)
+                        == (memcmp(text + pos, text + 1, len) == 0);
+            }
+        }
+        find_ok = find_ok
+                && ringbuffer_find(&rb, 0, (uint8_t*)"zz", 2) == -1;
+    }
+
+    check("find: same result at every wrap point", find_ok);
+    check("equal: same result at every wrap point", equal_ok);
+
+    /* Offsets beyond the content are rejected with empty segments */
+    ringbuffer_segments_t seg;
+    wrap_fill(&rb, mem, sizeof(mem), text, TEXT_LEN, 20);
+    check("segments: offset at end describes nothing",
+            ringbuffer_get_segments(&rb, TEXT_LEN, 8, &seg) == 0
+            && seg.len[0] == 0 && seg.len[1] == 0);
+    check("segments: offset beyond end is rejected",
+            ringbuffer_get_segments(&rb, TEXT_LEN + 1, 8, &seg) == -1
+            && seg.len[0] == 0 && seg.len[1] == 0
+            && seg.data[0] == mem && seg.data[1] == mem);
+}
+
+
+
+void test_utf8(void) {
+
+    /* Sequences embedded in 18 bytes of valid content before and 16 bytes
+     * after, with the offset of the first invalid byte (-1 = valid) */
+    static const struct {
+        const char* seq;
+        int invalid;
+    } cases[] = {
+        { "\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 \xF4\x8F\xBF\xBF", -1 },
+        { "\xED\x9F\xBF\xEE\x80\x80\xE0\xA0\x80\xF0\x90\x80\x80", -1 },
+        { "\xC0\xAF", 18 },             /* overlong two-byte form */
+        { "\xE0\x9F\xBF", 19 },         /* overlong three-byte form */
+        { "\xF0\x8F\xBF\xBF", 19 },     /* overlong four-byte form */
+        { "\xED\xA0\x80", 19 },         /* surrogate */
+        { "\xF4\x90\x80\x80", 19 },     /* beyond U+10FFFF */
+        { "\xF5\x80\x80\x80", 18 },     /* invalid lead byte */
+        { "\x80", 18 },                 /* stray continuation byte */
+        { "\xE2\x82" "A", 20 },         /* sequence too short */
+        { "\xC3\xA9\xA9", 20 },         /* sequence too long */
+    };
+
+    uint8_t mem[128];
+    uint8_t data[80];
+    ringbuffer_t rb;
+    ringbuffer_utf8_t v;
+    int accept_ok = 1;
+    int reject_ok = 1;
+    int resume_ok = 1;
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+
+        size_t slen = strlen(cases[c].seq);
+        memcpy(data, "0123456789abcde\xC3\xA9", 18);
+        memcpy(data + 18, cases[c].seq, slen);
+        memcpy(data + 18 + slen, "0123456789abcdef", 16);
+        size_t len = 18 + slen + 16;
+
+        for (size_t split = 0; split <= len; split++) {
+
+            wrap_fill(&rb, mem, sizeof(mem), data, len, split);
+            ringbuffer_utf8_init(&v);
+            int res = ringbuffer_utf8_validate(&v, &rb);
+
+            if (cases[c].invalid < 0) {
+                accept_ok = accept_ok && res == (int)len;
+            } else {
+                reject_ok = reject_ok && res == -2
+                        && v.offset == (size_t)cases[c].invalid;
+            }
+
+            if (cases[c].invalid >= 0) {
+                continue;
+            }
+
+            /* Validate in two steps, cutting the content at <split> */
+            wrap_fill(&rb, mem, sizeof(mem), data, split, split);
+            ringbuffer_utf8_init(&v);
+            res = ringbuffer_utf8_validate(&v, &rb);
+            resume_ok = resume_ok && res >= 0 && (size_t)res <= split
+                    && res + 3 >= (int)split;
+            ringbuffer_write(&rb, data + split, len - split);
+            resume_ok = resume_ok
+                    && ringbuffer_utf8_validate(&v, &rb) == (int)len;
+        }
+    }
+
+    check("utf8: valid content accepted across wrap", accept_ok);
+    check("utf8: invalid content rejected across wrap", reject_ok);
+    check("utf8: sequences cut between calls resumed", resume_ok);
+}
+
+
+
+void test_index_wrap(void) {
+
+    static const uint8_t bytes[] = { 'a', 'b', 'd', 'x', 'q' };
+
+    uint8_t mem[48];
+    ringbuffer_t rb;
+    size_t offsets[64];
+    int ok = 1;
+
+    for (size_t split = 0; split <= TEXT_LEN; split++) {
+        wrap_fill(&rb, mem, sizeof(mem), text, TEXT_LEN, split);
+        for (size_t k = 0; k < sizeof(bytes); k++) {
+            for (size_t offset = 0; offset < 10; offset++) {
+                for (size_t max = 2; max <= 64; max *= 4) {
+
+                    size_t len = TEXT_LEN - offset - (offset & 3);
+                    int n = ringbuffer_index_byte(&rb, offset, len,
+                            bytes[k], offsets, max);
+
+                    /* Compare with the occurrences in the linear text */
+                    size_t m = 0;
+                    for (size_t i = offset; i < offset + len && m < max; i++) {
+                        if (text[i] == bytes[k]) {
+                            ok = ok && m < (size_t)n && offsets[m] == i;
+                            m++;
+                        }
+                    }
+                    ok = ok && n == (int)m;
+                }
+            }
+        }
+    }
+
+    check("index_byte: same offsets at every wrap point", ok);
+}
+
+
+
+void test_find_any_wrap(void) {
+
+    static const char* sets[] = { "x", "yz", "dq", "\xFF\x80", "c\xE1z" };
+
+    uint8_t mem[48];
+    ringbuffer_t rb;
+    ringbuffer_byteset_t set;
+    int ok = 1;
+
+    for (size_t s = 0; s < sizeof(sets) / sizeof(sets[0]); s++) {
+
+        size_t slen = strlen(sets[s]);
+        ringbuffer_byteset_init(&set, (const uint8_t*)sets[s], slen);
+
+        for (size_t split = 0; split <= TEXT_LEN; split++) {
+            wrap_fill(&rb, mem, sizeof(mem), text, TEXT_LEN, split);
+            for (size_t offset = 0; offset <= TEXT_LEN; offset++) {
+
+                /* First byte of the linear text that is in the set */
+                int expected = -1;
+                for (size_t i = offset; i < TEXT_LEN && expected < 0; i++) {
+                    if (memchr(sets[s], text[i], slen) != 0) {
+                        expected = i;
+                    }
+                }
+
+                ok = ok && ringbuffer_find_any(&rb, offset, &set) == expected;
+            }
+        }
+    }
+
+    check("find_any: same result at every wrap point", ok);
+}
+
+
+
+void test_dfa(void) {
+
+    /* Patterns with the end offsets of their matches in the text (0 ends
+     * the list) */
+    static const struct {
+        const char* pattern;
+        size_t ends[8];
+    } cases[] = {
+        { "abd", { 6, 15, 27, 0 } },
+        { "x[yz]+", { 17, 18, 38, 39, 0 } },
+        { "ab[^c]", { 6, 15, 27, 30, 37, 0 } },
+        { "c.b", { 5, 11, 14, 23, 26, 36, 0 } },
+        { "d\\x61", { 7, 28, 32, 0 } },
+        { "[xyz]d", { 31, 40, 0 } },
+    };
+
+    static ringbuffer_dfa_t dfa;
+    ringbuffer_dfa_match_t m;
+    uint8_t mem[48];
+    ringbuffer_t rb;
+    size_t ends[16];
+    int whole_ok = 1;
+    int split_ok = 1;
+    int max_ok = 1;
+
+    check("dfa: empty match rejected",
+            ringbuffer_dfa_compile(&dfa, "a*") == -1);
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+
+        size_t n = 0;
+        while (cases[c].ends[n] != 0) {
+            n++;
+        }
+
+        if (ringbuffer_dfa_compile(&dfa, cases[c].pattern) < 0) {
+            whole_ok = 0;
+            continue;
+        }
+
+        for (size_t split = 0; split <= TEXT_LEN; split++) {
+
+            /* All content at once */
+            wrap_fill(&rb, mem, sizeof(mem), text, TEXT_LEN, split);
+            ringbuffer_dfa_match_init(&m, &dfa);
+            int k = ringbuffer_dfa_match(&m, &rb, ends, 16);
+            whole_ok = whole_ok && k == (int)n
+                    && memcmp(ends, cases[c].ends, n * sizeof(size_t)) == 0;
+
+            /* Content cut at <split> between two calls */
+            wrap_fill(&rb, mem, sizeof(mem), text, split, split);
+            ringbuffer_dfa_match_init(&m, &dfa);
+            k = ringbuffer_dfa_match(&m, &rb, ends, 16);
+            ringbuffer_write(&rb, text + split, TEXT_LEN - split);
+            k += ringbuffer_dfa_match(&m, &rb, ends + k, 16 - k);
+            split_ok = split_ok && k == (int)n
+                    && memcmp(ends, cases[c].ends, n * sizeof(size_t)) == 0;
+
+            /* One match per call */
+            wrap_fill(&rb, mem, sizeof(mem), text, TEXT_LEN, split);
+            ringbuffer_dfa_match_init(&m, &dfa);
+            for (size_t i = 0; i <= n; i++) {
+                k = ringbuffer_dfa_match(&m, &rb, ends, 1);
+                max_ok = max_ok && k == (i < n)
+                        && (k == 0 || ends[0] == cases[c].ends[i]);
+            }
+        }
+    }
+
+    check("dfa: matches at every wrap point", whole_ok);
+    check("dfa: matches resumed between calls", split_ok);
+    check("dfa: matching stops and resumes at the limit", max_ok);
+}
+
+
+
+void test_rfind_wrap(void) {
+
+    uint8_t mem[48];
+    ringbuffer_t rb;
+    int ok = 1;
+
+    for (size_t split = 0; split <= TEXT_LEN; split++) {
+        wrap_fill(&rb, mem, sizeof(mem), text, TEXT_LEN, split);
+        for (size_t pos = 0; pos < TEXT_LEN; pos++) {
+            for (size_t len = 1; len <= 6 && pos + len <= TEXT_LEN; len++) {
+                for (size_t offset = 0; offset <= TEXT_LEN + 1;
+                        offset++) {
+
+                    /* Last occurrence in the linear text */
+                    int expected = -1;
+                    for (size_t i = offset; i + len <= TEXT_LEN; i++) {
+                        if (memcmp(text + i, text + pos, len) == 0) {
+                            expected = i;
+                        }
+                    }
+
+                    ok = ok && ringbuffer_rfind(&rb, offset,
+                            text + pos, len) == expected;
+                }
+            }
+        }
+        ok = ok && ringbuffer_rfind(&rb, 0, (const uint8_t*)"zz", 2) == -1;
+    }
+
+    check("rfind: same result at every wrap point", ok);
+}
+
+
+
+void test_hash(void) {
+
+    /* Known XXH64 values (seed 0) */
+    static const struct {
+        const char* data;
+        uint64_t hash;
+    } vectors[] = {
+        { "", 0xEF46DB3751D8E999ULL },
+        { "a", 0xD24EC4F1A98C6E5BULL },
+        { "abc", 0x44BC2CF5AD770999ULL },
+        { "Nobody inspects the spammish repetition", 0xFBCEA83C8A378BF1ULL },
+    };
+
+    uint8_t mem[48];
+    ringbuffer_t rb;
+    ringbuffer_hash_t h;
+    uint64_t hash = 0;
+    int vectors_ok = 1;
+    int wrap_ok = 1;
+
+    for (size_t v = 0; v < sizeof(vectors) / sizeof(vectors[0]); v++) {
+
+        size_t len = strlen(vectors[v].data);
+
+        for (size_t split = 0; split <= len; split++) {
+            wrap_fill(&rb, mem, sizeof(mem),
+                    (const uint8_t*)vectors[v].data, len, split);
+            vectors_ok = vectors_ok
+                    && ringbuffer_hash(&rb, 0, len, 0, &hash) == (int)len
+                    && hash == vectors[v].hash;
+        }
+    }
+
+    /* Streaming ranges of the text in pieces gives the one-shot hash */
+    uint64_t expected[TEXT_LEN + 1];
+    wrap_fill(&rb, mem, sizeof(mem), text, TEXT_LEN, 0);
+    for (size_t len = 0; len <= TEXT_LEN; len++) {
+        ringbuffer_hash(&rb, 0, len, 7, &expected[len]);
+    }
+
+    for (size_t split = 0; split <= TEXT_LEN; split++) {
+        wrap_fill(&rb, mem, sizeof(mem), text, TEXT_LEN, split);
+        for (size_t len = 0; len <= TEXT_LEN; len++) {
+            ringbuffer_hash_init(&h, 7);
+            ringbuffer_hash_update_ring(&h, &rb, 0, len / 3);
+            ringbuffer_hash_update_ring(&h, &rb, len / 3, len - len / 3);
+            wrap_ok = wrap_ok && ringbuffer_hash_final(&h) == expected[len];
+        }
+    }
+
+    check("hash: XXH64 test vectors at every wrap point", vectors_ok);
+    check("hash: streamed pieces match one-shot hash", wrap_ok);
+}
+
+
+
+void test_parallel(void) {
+
+    uint8_t mem[48];
+    ringbuffer_t rb;
+    uint32_t crc = 0;
+    int crc_ok = 1;
+    int combine_ok = 1;
+    int chunks_ok = 1;
+    int find_ok = 1;
 
+    /* The CRC-32 check value */
+    for (size_t split = 0; split <= 9; split++) {
+        wrap_fill(&rb, mem, sizeof(mem), (const uint8_t*)"123456789", 9, split);
+        for (size_t nchunks = 1; nchunks <= 4; nchunks++) {
+            crc_ok = crc_ok && ringbuffer_crc32_parallel(&rb, 0, 9, &crc,
+                    nchunks, 0, 0) == 9 && crc == 0xCBF43926UL;
+        }
+    }
+
+    uint32_t crc1 = ringbuffer_crc32_update(0, (const uint8_t*)"12345", 5);
+    uint32_t crc2 = ringbuffer_crc32_update(0, (const uint8_t*)"6789", 4);
+    combine_ok = ringbuffer_crc32_combine(crc1, crc2, 4) == 0xCBF43926UL;
+
+    /* Chunked search and CRC-32 equal their single-pass counterparts */
+    uint32_t expected = ringbuffer_crc32_update(0, text, TEXT_LEN);
+    for (size_t split = 0; split <= TEXT_LEN; split++) {
+        wrap_fill(&rb, mem, sizeof(mem), text, TEXT_LEN, split);
+        for (size_t nchunks = 1; nchunks <= 8; nchunks++) {
+            chunks_ok = chunks_ok && ringbuffer_crc32_parallel(&rb, 0, TEXT_LEN,
+                    &crc, nchunks, 0, 0) == (int)TEXT_LEN && crc == expected;
+            for (size_t pos = 0; pos + 4 <= TEXT_LEN; pos += 3) {
+                find_ok = find_ok && ringbuffer_find_parallel(&rb, 1,
+                        text + pos, 4, nchunks, 0, 0)
+                        == naive_find(1, text + pos, 4);
+            }
+        }
+    }
+
+    check("crc32: check value at every wrap point", crc_ok);
+    check("crc32: combined from two blocks", combine_ok);
+    check("crc32_parallel: same value for all chunk counts", chunks_ok);
+    check("find_parallel: same result for all chunk counts", find_ok);
+}
+
+
+
+void test_replica(void) {
+
+    uint8_t mem[48];
+    uint64_t mirror_mem[(RINGBUFFER_MIRROR_SIZEOF(48) + 7) / 8];
+    ringbuffer_mirror_t* mirror = (ringbuffer_mirror_t*)mirror_mem;
+    uint8_t standby_mem[sizeof(mirror_mem)];
+    ringbuffer_t rb;
+    ringbuffer_t standby;
+    ringbuffer_replica_t r;
+    uint8_t content[48];
+    int ok = 1;
+
+    ringbuffer_init(&rb, mem, sizeof(mem));
+    ringbuffer_write(&rb, text, 10);
+    ringbuffer_replica_init(&r, &rb, mirror);
+
+    /* Rounds of writes and reads of varying amounts between commits; the
+     * last rounds write more than a buffer's worth between commits */
+    for (size_t round = 0; round < 60; round++) {
+
+        size_t amount = (round < 50) ? round % 7 * 5 : 30;
+        for (size_t i = 0; i < 1 + round / 50; i++) {
+            ringbuffer_discard(&rb, amount);
+            ringbuffer_write(&rb, text + round % 10, amount);
+        }
+        ringbuffer_replica_commit(&r);
+
+        /* A standby takes over a copy of the mirror */
+        memcpy(standby_mem, mirror_mem, sizeof(mirror_mem));
+        ringbuffer_replica_attach(&standby,
+                (ringbuffer_mirror_t*)standby_mem);
+
+        ringbuffer_peek(&rb, content, rb.len);
+        ok = ok && standby.len == rb.len && standby.ir == rb.ir
+                && ringbuffer_equal(&standby, 0, content, rb.len) == 1;
+    }
+
+    check("replica: standby attaches to committed content", ok);
+}
+
+
+
+void test_seq(void) {
+
+    /* Room for two blocks of 8 bytes (plus length and sequence number) */
+    uint8_t mem[64];
+    uint8_t block[8];
+    ringbuffer_t rb;
+    ringbuffer_seq_t s;
+    uint64_t seq = 0;
+    uint64_t gap = 0;
+
+    ringbuffer_init(&rb, mem, sizeof(mem));
+    ringbuffer_seq_init(&s, &rb);
+
+    ringbuffer_seq_write_block(&s, text, 8, 0);
+    ringbuffer_seq_write_block(&s, text + 8, 8, 0);
+    check("seq: full ringbuffer refuses lossless write",
+            ringbuffer_seq_write_block(&s, text, 8, 0) == -1);
+    check("seq: block read without gap",
+            ringbuffer_seq_read_block(&s, block, 8, &seq, &gap) == 8
+            && seq == 0 && gap == 0 && memcmp(block, text, 8) == 0);
+
+    /* Lossy writes evict blocks 1 to 7 */
+    for (size_t i = 2; i < 10; i++) {
+        ringbuffer_seq_write_block(&s, text + i, 8, 1);
+    }
+    check("seq: lag counts evicted blocks",
+            ringbuffer_seq_get_producer(&s) == 10
+            && ringbuffer_seq_get_consumer(&s) == 1
+            && ringbuffer_seq_get_lag(&s) == 9);
+    check("seq: gap reported before next block",
+            ringbuffer_seq_read_block(&s, block, 8, &seq, &gap) == 8
+            && seq == 8 && gap == 7 && memcmp(block, text + 8, 8) == 0);
+    check("seq: last block read without gap",
+            ringbuffer_seq_read_block(&s, block, 8, &seq, &gap) == 8
+            && seq == 9 && gap == 0);
+    check("seq: lost blocks accounted",
+            ringbuffer_seq_get_lost(&s) == 7 && ringbuffer_seq_get_lag(&s) == 0
+            && ringbuffer_seq_read_block(&s, block, 8, &seq, &gap) == -1);
+}
+
+
+
+void test_pipeline(void) {
+
+    /* Three stages: stage 0 increments every payload byte in place, stages
+     * 1 and 2 check that they see the blocks in order and processed */
+    uint8_t mem[64];
+    size_t cursors[3];
+    ringbuffer_t rb;
+    ringbuffer_pipeline_t pl;
+    ringbuffer_segments_t seg;
+    size_t next[4] = { 0, 0, 0, 0 };
+    uint8_t block[8];
+    int order_ok = 1;
+    int barrier_ok = 1;
+
+    ringbuffer_init(&rb, mem, sizeof(mem));
+    ringbuffer_pipeline_init(&pl, &rb, cursors, 3);
+
+    for (int step = 0; step < 2000; step++) {
+
+        /* Block k has k % 7 payload bytes (k + j), so some are empty */
+        size_t k = next[3];
+        for (size_t j = 0; j < k % 7; j++) {
+            block[j] = (uint8_t)(k + j);
+        }
+        if (ringbuffer_write_block(&rb, block, k % 7) > 0) {
+            next[3]++;
+        }
+
+        /* Stages run at different paces */
+        for (size_t stage = 0; stage < 3; stage++) {
+            if ((step + stage) % (stage + 2) != 0) {
+                continue;
+            }
+            int bl = ringbuffer_pipeline_get_block(&pl, stage, &seg);
+            if (ringbuffer_pipeline_peek_block_length(&pl, stage) < 0) {
+                order_ok = 0;
+                continue;
+            }
+            if (ringbuffer_pipeline_get_length(&pl, stage) == 0) {
+                continue;
+            }
+            k = next[stage];
+            order_ok = order_ok && bl == (int)(k % 7);
+            for (int j = 0; j < bl; j++) {
+                uint8_t* b = (size_t)j < seg.len[0]
+                        ? seg.data[0] + j : seg.data[1] + j - seg.len[0];
+                if (stage == 0) {
+                    order_ok = order_ok && *b == (uint8_t)(k + j);
+                    (*b)++;
+                } else {
+                    order_ok = order_ok && *b == (uint8_t)(k + j + 1);
+                }
+            }
+            order_ok = order_ok && ringbuffer_pipeline_advance_block(
+                    &pl, stage) == (int)(sizeof(size_t) + k % 7);
+            next[stage]++;
+            barrier_ok = barrier_ok && (stage == 0
+                    || next[stage] <= next[stage - 1]);
+        }
+    }
+
+    /* Drain: empty blocks are released like any other */
+    for (size_t stage = 0; stage < 3; stage++) {
+        while (ringbuffer_pipeline_advance_block(&pl, stage) > 0) {
+            next[stage]++;
+        }
+    }
+
+    check("pipeline: blocks in order across wraps",
+            order_ok && next[2] > 100);
+    check("pipeline: stages never overtake upstream", barrier_ok);
+    check("pipeline: drained including empty blocks",
+            next[0] == next[3] && next[2] == next[3] && rb.len == 0
+            && ringbuffer_pipeline_advance_block(&pl, 2) == 0);
+}
+
+
+
+/* An object pointing to itself, so it needs a move function */
+typedef struct obj {
+    struct obj* self;
+    int value;
+} obj_t;
+
+static int obj_destroyed = 0;
+static int obj_broken = 0;
+
+static void obj_move(void* dst, void* src) {
+    obj_t* d = (obj_t*)dst;
+    obj_t* s = (obj_t*)src;
+    d->self = d;
+    d->value = s->value;
+    s->value = -1;
+}
+
+static void obj_destroy(void* p) {
+    obj_t* o = (obj_t*)p;
+    obj_broken += (o->self != o);
+    obj_destroyed++;
+}
+
+
+
+void test_objq(void) {
+
+    uint8_t mem[5 * sizeof(obj_t) + 3];
+    ringbuffer_objq_t q;
+    obj_t out;
+    obj_t* o;
+    int ok = 1;
+
+    check("objq: whole objects only",
+            ringbuffer_objq_init(&q, mem, sizeof(mem), sizeof(obj_t),
+            obj_move, obj_destroy) == 5);
+
+    for (int i = 0; i < 5; i++) {
+        o = ringbuffer_objq_emplace(&q);
+        o->self = o;
+        o->value = i;
+    }
+    check("objq: emplace into full queue fails",
+            ringbuffer_objq_emplace(&q) == 0
+            && ringbuffer_objq_get_length(&q) == 5);
+
+    check("objq: pop moves oldest and destroys source",
+            ringbuffer_objq_pop(&q, &out) == sizeof(obj_t) && out.value == 0
+            && out.self == &out && obj_destroyed == 1 && obj_broken == 0);
+
+    /* Keep the queue going around the end of the buffer */
+    int expected = 1;
+    for (int i = 5; i < 40; i++) {
+        o = ringbuffer_objq_emplace(&q);
+        o->self = o;
+        o->value = i;
+        ok = ok && ringbuffer_objq_pop(&q, &out) == sizeof(obj_t)
+                && out.value == expected++ && out.self == &out;
+    }
+    check("objq: FIFO order across wraps",
+            ok && obj_destroyed == 36 && obj_broken == 0);
+
+    check("objq: discard destroys in place",
+            ringbuffer_objq_discard(&q, 2) == 2 && obj_destroyed == 38
+            && ((obj_t*)ringbuffer_objq_front(&q))->value == 38);
+    check("objq: clear destroys the rest",
+            ringbuffer_objq_clear(&q) == 2 && obj_destroyed == 40
+            && obj_broken == 0);
+    check("objq: empty queue",
+            ringbuffer_objq_pop(&q, &out) == 0
+            && ringbuffer_objq_front(&q) == 0);
+
+    /* Without a move function, objects are relocated bitwise and the
+     * caller takes ownership */
+    ringbuffer_objq_init(&q, mem, sizeof(mem), sizeof(obj_t), 0, obj_destroy);
+    o = ringbuffer_objq_emplace(&q);
+    o->self = &out;
+    o->value = 7;
+    check("objq: bitwise pop without destructor call",
+            ringbuffer_objq_pop(&q, &out) == sizeof(obj_t) && out.value == 7
+            && obj_destroyed == 40);
+}
+
+
+
+void test_stream(void) {
+
+    uint8_t mem[128];
+    uint8_t data[200];
+    uint8_t out[200];
+    ringbuffer_t rb;
+    ringbuffer_t other;
+    int trip_ok = 1;
+
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 7 + 3);
+    }
+
+    /* Streamed writes (threshold below the write length, but above the
+     * parts on either side of the wrap point) must round-trip unchanged at
+     * every wrap position */
+    for (size_t split = 0; split <= 100; split++) {
+        wrap_fill(&rb, mem, sizeof(mem), text, 0, split);
+        ringbuffer_set_stream_threshold(&rb, 64);
+        trip_ok = trip_ok
+                && ringbuffer_write(&rb, data, 100) == 100
+                && ringbuffer_write(&rb, data + 100, 20) == 20
+                && ringbuffer_read(&rb, out, 120) == 120
+                && memcmp(out, data, 120) == 0;
+    }
+
+    /* Setting the threshold (where supported) leaves other rings alone */
+    ringbuffer_init(&other, out, sizeof(out));
+    int set = ringbuffer_set_stream_threshold(&rb, 32);
+    check("stream: threshold is set per ringbuffer",
+            rb.stream_threshold
+            == (set == 0 ? 32 : RINGBUFFER_STREAM_THRESHOLD)
+            && other.stream_threshold == RINGBUFFER_STREAM_THRESHOLD
+            && ringbuffer_set_stream_threshold(0, 32) == -1);
+    check("stream: writes round-trip across the wrap", trip_ok);
+}
+
+
+
+void test_compact(void) {
+
+    uint8_t mem[RINGBUFFER_COMPACT_SIZEOF(48)];
+    size_t max = (rb_compact_index_t)-1;
+    int wrap_ok = 1;
+
+    /* The capacity is limited by the index width */
+    ringbuffer_compact_t* rbc = ringbuffer_compact_init(
+            mem, sizeof(ringbuffer_compact_t) + max);
+    check("compact: largest indexable capacity accepted",
+            rbc != 0 && rbc->size == max);
+    check("compact: capacity beyond index width rejected",
+            ringbuffer_compact_init(
+                    mem, sizeof(ringbuffer_compact_t) + max + 1) == 0
+            && ringbuffer_compact_init(
+                    mem, sizeof(ringbuffer_compact_t) - 1) == 0);
+
+    /* Write the text across every wrap point, then search, peek and read
+     * it back; the narrow indices must stay within the capacity */
+    for (size_t split = 0; split <= TEXT_LEN; split++) {
+
+        uint8_t junk[48] = { 0 };
+        uint8_t out[TEXT_LEN];
+
+        rbc = ringbuffer_compact_init(mem, sizeof(mem));
+        ringbuffer_compact_write(rbc, junk, 48 - split);
+        ringbuffer_compact_discard(rbc, 48 - split);
+
+        wrap_ok = wrap_ok
+                && ringbuffer_compact_write(rbc, text, TEXT_LEN) == TEXT_LEN
+                && ringbuffer_compact_write_all(rbc, junk, 9) == -1
+                && ringbuffer_compact_write(rbc, junk, 9) == 8
+                && ringbuffer_compact_get_space(rbc) == 0
+                && rbc->iw < rbc->size && rbc->ir < rbc->size
+                && ringbuffer_compact_find(rbc, 1, (uint8_t*)"abxyz", 5) == 34
+                && ringbuffer_compact_peek_offset(rbc, 30, out, 4) == 4
+                && memcmp(out, text + 30, 4) == 0
+                && ringbuffer_compact_read(rbc, out, TEXT_LEN) == TEXT_LEN
+                && memcmp(out, text, TEXT_LEN) == 0
+                && ringbuffer_compact_get_length(rbc) == 8;
+    }
+
+    check("compact: content survives every wrap point", wrap_ok);
+}
+
+
+
+/* Writes, peeks and reads back the text and blocks starting at every
+ * position of the buffer, with free-running indices starting near 0 and
+ * near their overflow */
+#define STATIC_ROUND_TRIP(prefix, capacity, hlen)                             \
+static int prefix##_round_trip(void) {                                       \
+    prefix##_t rb;                                                           \
+    uint8_t out[(capacity)];                                                 \
+    int ok = (prefix##_init(&rb) == (capacity));                             \
+    for (size_t i = 0; i < 2 * (capacity); i++) {                            \
+        rb.iw = rb.ir = i - (capacity);                                      \
+        ok = ok && prefix##_write(&rb, text, TEXT_LEN) == TEXT_LEN           \
+                && prefix##_get_space(&rb) == (capacity) - TEXT_LEN          \
+                && prefix##_write_all(&rb, out,                              \
+                        (capacity) - TEXT_LEN + 1) == -1                     \
+                && prefix##_peek_offset(&rb, 5, out, 10) == 10               \
+                && memcmp(out, text + 5, 10) == 0                            \
+                && prefix##_read(&rb, out, TEXT_LEN) == TEXT_LEN             \
+                && memcmp(out, text, TEXT_LEN) == 0;                         \
+        ok = ok && prefix##_write_block(&rb, text, 7) == (hlen) + 7          \
+                && prefix##_write_block(&rb, text, 0) == (hlen)              \
+                && prefix##_write_block(&rb, text + 7, 9) == (hlen) + 9      \
+                && prefix##_peek_block_length(&rb) == 7                      \
+                && prefix##_read_block(&rb, out, 7) == 7                     \
+                && memcmp(out, text, 7) == 0                                 \
+                && prefix##_read_block(&rb, out, 0) == 0                     \
+                && prefix##_get_length(&rb) == (int)(hlen) + 9               \
+                && prefix##_discard_block(&rb) == (int)(hlen) + 9            \
+                && prefix##_get_length(&rb) == 0;                            \
+    }                                                                        \
+    return ok;                                                               \
+}
+
+STATIC_ROUND_TRIP(srb, 64, sizeof(size_t))
+STATIC_ROUND_TRIP(srb8, 512, 1)
+STATIC_ROUND_TRIP(srbu, 64, 2)
+
+
+
+void test_static(void) {
+
+    check("static: round trips at every wrap point",
+            srb_round_trip() && srb8_round_trip() && srbu_round_trip());
+
+    /* Block lengths are limited by the width of the length field */
+    uint8_t block[256] = { 0 };
+    srb8_t rb8;
+    srb8_init(&rb8);
+    check("static: narrow length field limits blocks",
+            srb8_write_block(&rb8, block, 256) == -1
+            && srb8_write_block(&rb8, block, 255) == 256
+            && srb8_peek_block_length(&rb8) == 255);
+
+    /* Checked rings reject corrupt length fields, unchecked ones take them
+     * as they are (and assert in discard) */
+    srb_t rb;
+    srb_init(&rb);
+    size_t bogus = 100;
+    srb_write(&rb, (const uint8_t*)&bogus, sizeof(bogus));
+    check("static: checked ring rejects corrupt length",
+            srb_peek_block_length(&rb) == -1
+            && srb_read_block(&rb, block, sizeof(block)) == 0
+            && srb_discard_block(&rb) == 0
+            && srb_get_length(&rb) == (int)sizeof(bogus)
+            && srb_write_block(0, block, 1) == -1);
+}
+
+
+
+int same_state(ringbuffer_t* a, ringbuffer_t* b) {
+
+    return a->len == b->len && a->iw == b->iw && a->ir == b->ir
+            && a->written == b->written
+            && memcmp(a->buffer, b->buffer, a->size) == 0;
+}
+
+
+
+void test_nocheck(void) {
+
+    uint8_t mem[2][48];
+    ringbuffer_t a;
+    ringbuffer_t b;
+    int ok = 1;
+
+    /* Apply the same operations to a ringbuffer through the checked and
+     * the unchecked functions, starting at every wrap point */
+    for (size_t split = 0; split <= sizeof(mem[0]); split++) {
+
+        uint8_t out[2][16];
+        uint8_t hdr[2][2];
+
+        wrap_fill(&a, mem[0], sizeof(mem[0]), text, 0, split);
+        wrap_fill(&b, mem[1], sizeof(mem[1]), text, 0, split);
+
+        ok = ok && ringbuffer_write(&a, text, 20)
+                == ringbuffer_write_nocheck(&b, text, 20)
+                && same_state(&a, &b);
+        ok = ok && ringbuffer_peek_offset(&a, 3, out[0], 10)
+                == ringbuffer_peek_offset_nocheck(&b, 3, out[1], 10)
+                && memcmp(out[0], out[1], 10) == 0 && same_state(&a, &b);
+        ok = ok && ringbuffer_read(&a, out[0], 5)
+                == ringbuffer_read_nocheck(&b, out[1], 5)
+                && memcmp(out[0], out[1], 5) == 0 && same_state(&a, &b);
+        ok = ok && ringbuffer_discard(&a, 4)
+                == ringbuffer_discard_nocheck(&b, 4)
+                && same_state(&a, &b);
+        ok = ok && ringbuffer_write_block(&a, text + 5, 9)
+                == ringbuffer_write_block_nocheck(&b, text + 5, 9)
+                && same_state(&a, &b);
+        ok = ok && ringbuffer_write_frame(&a,
+                (uint8_t*)"HD", 2, (uint8_t*)text + 10, 6)
+                == ringbuffer_write_frame_nocheck(&b,
+                (const uint8_t*)"HD", 2, text + 10, 6)
+                && same_state(&a, &b);
+        ok = ok && ringbuffer_discard(&a, 11)
+                == ringbuffer_discard_nocheck(&b, 11)
+                && same_state(&a, &b);
+        ok = ok && ringbuffer_read_block(&a, out[0], 16)
+                == ringbuffer_read_block_nocheck(&b, out[1], 16)
+                && memcmp(out[0], text + 5, 9) == 0
+                && memcmp(out[1], text + 5, 9) == 0 && same_state(&a, &b);
+        ok = ok && ringbuffer_read_frame(&a, hdr[0], 2, out[0], 8)
+                == ringbuffer_read_frame_nocheck(&b, hdr[1], 2, out[1], 8)
+                && memcmp(hdr[0], "HD", 2) == 0 && memcmp(hdr[1], "HD", 2) == 0
+                && memcmp(out[0], text + 10, 6) == 0
+                && memcmp(out[1], text + 10, 6) == 0
+                && same_state(&a, &b) && a.len == 0;
+    }
+
+    check("nocheck: same results as checked functions", ok);
+}
+
+
+
+void test_trace(void) {
+
+    static const char* path = "test.rbtr";
+    static const ringbuffer_trace_record_t expected[] = {
+        { RINGBUFFER_OP_WRITE, 5, 0, 0 },
+        { RINGBUFFER_OP_WRITE_ALL, 3, 0, 0 },
+        { RINGBUFFER_OP_PEEK, 4, 2, 0 },
+        { RINGBUFFER_OP_FIND, 2, 1, 0 },
+        { RINGBUFFER_OP_READ, 8, 0, 0 },
+        { RINGBUFFER_OP_WRITE_BLOCK, 6, 0, 0 },
+        { RINGBUFFER_OP_PEEK_BLOCK, 16, 0, 0 },
+        { RINGBUFFER_OP_READ_BLOCK, 16, 0, 0 },
+        { RINGBUFFER_OP_WRITE_FRAME, 4, 2, 0 },
+        { RINGBUFFER_OP_READ_FRAME, 16, 2, 0 },
+        { RINGBUFFER_OP_WRITE_BLOCK, 1, 0, 0 },
+        { RINGBUFFER_OP_DISCARD_BLOCK, 0, 0, 0 },
+        { RINGBUFFER_OP_DISCARD, 7, 0, 0 },
+        { RINGBUFFER_OP_CLEAR, 0, 0, 0 },
+    };
+    const size_t nexpected = sizeof(expected) / sizeof(expected[0]);
+
+    uint8_t mem[64];
+    uint8_t other_mem[8];
+    uint8_t out[16];
+    ringbuffer_t rb;
+    ringbuffer_t other;
+    ringbuffer_trace_t tr;
+
+    ringbuffer_init(&rb, mem, sizeof(mem));
+    ringbuffer_init(&other, other_mem, sizeof(other_mem));
+
+    if (ringbuffer_trace_start(&tr, path, &rb) < 0) {
+        /* >>> Tracing not compiled in: nothing to record >>> */
+        check("trace: no recording without RINGBUFFER_TRACE",
+                tr.file == 0 && ringbuffer_set_trace_hook(0, 0) == 0);
+        remove(path);
+        return;
+    }
+
+    /* Record one operation of each kind (those on other rings are not
+     * recorded) */
+    ringbuffer_write(&rb, text, 5);
+    ringbuffer_write(&other, text, 5);
+    ringbuffer_write_all(&rb, text, 3);
+    ringbuffer_peek_offset(&rb, 2, out, 4);
+    ringbuffer_find(&rb, 1, (uint8_t*)text + 1, 2);
+    ringbuffer_read(&rb, out, 8);
+    ringbuffer_write_block(&rb, text, 6);
+    ringbuffer_peek_block(&rb, out, 16);
+    ringbuffer_read_block(&rb, out, 16);
+    ringbuffer_write_frame(&rb, (uint8_t*)"HD", 2, (uint8_t*)text, 4);
+    ringbuffer_read_frame(&rb, out, 2, out + 2, 16);
+    ringbuffer_write_block(&rb, text, 1);
+    ringbuffer_discard_block(&rb);
+    ringbuffer_discard(&rb, 7);
+    ringbuffer_clear(&rb);
+    ringbuffer_trace_stop(&tr);
+
+    /* Operations after stopping are not recorded either */
+    ringbuffer_write(&rb, text, 5);
+
+    /* Replay: the same operations with the same arguments, in order */
+    int size = ringbuffer_trace_open(&tr, path);
+    ringbuffer_trace_record_t rec;
+    size_t n = 0;
+    int same = 1;
+    int ret;
+
+    while ((ret = ringbuffer_trace_next(&tr, &rec)) > 0) {
+        same = same && n < nexpected && rec.op == expected[n].op
+                && rec.len == expected[n].len && rec.aux == expected[n].aux;
+        n++;
+    }
+    ringbuffer_trace_close(&tr);
+    remove(path);
+
+    check("trace: records replay in order",
+            size == (int)sizeof(mem) && ret == 0 && same && n == nexpected);
+}
+
+
+
+void test_credit(void) {
+
+    uint8_t mem[100];
+    uint8_t out[100] = { 0 };
+    ringbuffer_t rb;
+    ringbuffer_credit_t c;
+
+    /* Batches must fit into the ringbuffer */
+    ringbuffer_init(&rb, mem, sizeof(mem));
+    check("credit: quantum beyond size is rejected",
+            ringbuffer_credit_init(&c, &rb, 101) == -1
+            && ringbuffer_credit_init(&c, &rb, 100) == 100);
+
+    /* With the quantum equal to the size, space is granted only once the
+     * ringbuffer has been drained */
+    check("credit: quantum of the full size is granted",
+            ringbuffer_credit_write(&c, out, 100) == 100
+            && ringbuffer_credit_read(&c, out, 40) == 40
+            && ringbuffer_credit_available(&c) == 0
+            && ringbuffer_credit_read(&c, out, 60) == 60
+            && ringbuffer_credit_available(&c) == 100);
+
+    /* Freed space is batched, but granted entirely once drained, even if
+     * short of the quantum (the producer would stall forever otherwise) */
+    ringbuffer_credit_init(&c, &rb, 64);
+    check("credit: freed space is granted in batches",
+            ringbuffer_credit_write(&c, out, 100) == 100
+            && ringbuffer_credit_read(&c, out, 30) == 30
+            && ringbuffer_credit_available(&c) == 0
+            && ringbuffer_credit_read(&c, out, 34) == 34
+            && ringbuffer_credit_available(&c) == 64
+            && ringbuffer_credit_read(&c, out, 36) == 36
+            && ringbuffer_credit_available(&c) == 100);
+    check("credit: draining grants space short of quantum",
+            ringbuffer_credit_write(&c, out, 50) == 50
+            && ringbuffer_credit_read(&c, out, 50) == 50
+            && ringbuffer_credit_write(&c, out, 60) == 60
+            && ringbuffer_credit_write(&c, out, 41) == -1);
+
+    /* Forwarding moves whole blocks as credits allow and returns the space
+     * freed upstream to its producer */
+    uint8_t upmem[64];
+    uint8_t downmem[40];
+    ringbuffer_t up;
+    ringbuffer_t down;
+    ringbuffer_credit_t cup;
+    ringbuffer_credit_t cdown;
+    ringbuffer_init(&up, upmem, sizeof(upmem));
+    ringbuffer_init(&down, downmem, sizeof(downmem));
+    ringbuffer_credit_init(&cup, &up, 0);
+    ringbuffer_credit_init(&cdown, &down, 0);
+
+    const size_t bl = sizeof(size_t) + 8;
+    int ok = 1;
+    for (size_t i = 0; i < 3; i++) {
+        ok = ok && ringbuffer_credit_write_block(&cup, text + 8 * i, 8)
+                == (int)bl;
+    }
+    ok = ok && ringbuffer_credit_available(&cup) == (int)(64 - 3 * bl)
+            && ringbuffer_credit_forward(&cup, &cdown) == (int)(2 * bl)
+            && ringbuffer_credit_available(&cup) == (int)(64 - bl)
+            && ringbuffer_credit_available(&cdown) == (int)(40 - 2 * bl)
+            && ringbuffer_credit_read_block(&cdown, out, 8) == 8
+            && memcmp(out, text, 8) == 0
+            && ringbuffer_credit_forward(&cup, &cdown) == (int)bl
+            && ringbuffer_credit_available(&cup) == 64
+            && ringbuffer_credit_forward(&cup, &cdown) == 0
+            && ringbuffer_credit_read_block(&cdown, out, 8) == 8
+            && memcmp(out, text + 8, 8) == 0
+            && ringbuffer_credit_read_block(&cdown, out, 8) == 8
+            && memcmp(out, text + 16, 8) == 0
+            && ringbuffer_credit_available(&cdown) == 40;
+    check("credit: forwarding releases upstream credits", ok);
+}
+
+
+
+int topic_next(ringbuffer_topic_t* t, size_t id, const uint8_t* msg) {
+
+    ringbuffer_segments_t seg;
+    uint8_t out[12];
+
+    /* Receive a 12-byte message in place, compare it and release it */
+    if (ringbuffer_topic_receive(t, id, &seg) != sizeof(out)) {
+        return 0;
+    }
+    memcpy(out, seg.data[0], seg.len[0]);
+    memcpy(out + seg.len[0], seg.data[1], seg.len[1]);
+
+    return memcmp(out, msg, sizeof(out)) == 0
+            && ringbuffer_topic_release(t, id) == sizeof(out);
+}
+
+
+
+void test_pubsub(void) {
+
+    /* Room for three 12-byte messages (20 bytes with header each) */
+    uint8_t mem[64];
+    size_t cursors[4];
+    ringbuffer_t rb;
+    ringbuffer_topic_t t;
+    ringbuffer_segments_t seg;
+    const int msg = 20;
+    int ok;
+
+    ringbuffer_init(&rb, mem, sizeof(mem));
+    ringbuffer_topic_init(&t, &rb, cursors, 4);
+
+    /* Without subscribers messages are dropped right away */
+    check("pubsub: nothing retained without subscribers",
+            ringbuffer_topic_publish(&t, text, 12) == msg
+            && ringbuffer_get_length(&rb) == 0);
+
+    /* Every subscriber receives every message; space is reclaimed once
+     * the last one has read it */
+    int a = ringbuffer_topic_subscribe(&t, RINGBUFFER_TOPIC_HEAD);
+    int b = ringbuffer_topic_subscribe(&t, RINGBUFFER_TOPIC_HEAD);
+    int c = ringbuffer_topic_subscribe(&t, RINGBUFFER_TOPIC_HEAD);
+    ok = ringbuffer_topic_publish(&t, text, 12) == msg
+            && ringbuffer_topic_publish(&t, text + 12, 12) == msg
+            && topic_next(&t, a, text) && topic_next(&t, b, text)
+            && ringbuffer_get_length(&rb) == 2 * msg
+            && topic_next(&t, c, text)
+            && ringbuffer_get_length(&rb) == msg;
+    for (int id = a; id <= c; id++) {
+        ok = ok && topic_next(&t, id, text + 12)
+                && ringbuffer_topic_receive(&t, id, &seg) == -1;
+    }
+    check("pubsub: messages fan out to every subscriber",
+            ok && ringbuffer_get_length(&rb) == 0);
+
+    /* A subscriber that doesn't read holds back space and eventually
+     * blocks publishing, while the others keep up (messages wrap) */
+    ok = 1;
+    for (int i = 0; i < 3; i++) {
+        ok = ok && ringbuffer_topic_publish(&t, text + 4 * i, 12) == msg
+                && topic_next(&t, a, text + 4 * i)
+                && topic_next(&t, b, text + 4 * i);
+    }
+    ok = ok && ringbuffer_topic_publish(&t, text, 12) == -1
+            && ringbuffer_topic_get_pending(&t, c) == 3 * msg
+            && topic_next(&t, c, text)
+            && ringbuffer_topic_publish(&t, text + 20, 12) == msg;
+    check("pubsub: slow subscriber blocks publishing", ok);
+
+    /* Unsubscribing the slow subscriber reclaims what it held back */
+    ok = ringbuffer_topic_unsubscribe(&t, c) == 0
+            && ringbuffer_get_length(&rb) == msg
+            && ringbuffer_topic_unsubscribe(&t, c) == -1;
+    check("pubsub: unsubscribing reclaims held space", ok);
+
+    /* Late subscribers join at the oldest retained message (head) or at
+     * the next message published (tail), reusing the freed slot */
+    int h = ringbuffer_topic_subscribe(&t, RINGBUFFER_TOPIC_HEAD);
+    int l = ringbuffer_topic_subscribe(&t, RINGBUFFER_TOPIC_TAIL);
+    ok = h == c && l == 3
+            && ringbuffer_topic_subscribe(&t, RINGBUFFER_TOPIC_TAIL) == -1
+            && ringbuffer_topic_get_pending(&t, h) == msg
+            && ringbuffer_topic_get_pending(&t, l) == 0
+            && ringbuffer_topic_receive(&t, l, &seg) == -1
+            && ringbuffer_topic_publish(&t, text + 28, 12) == msg
+            && topic_next(&t, h, text + 20) && topic_next(&t, h, text + 28)
+            && topic_next(&t, l, text + 28);
+    check("pubsub: late subscribers join at head or tail", ok);
+}